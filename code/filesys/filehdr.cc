@@ -250,6 +250,35 @@ void FileHeader::WriteBack(int sector)
 	}
 }
 
+//----------------------------------------------------------------------
+// FileHeader::Sync
+// 	Flush the file header, any lower level headers, and the data
+//	sectors of the file out of the disk cache.
+//
+//	"sector" is the disk sector containing the file header
+//----------------------------------------------------------------------
+void FileHeader::Sync(int sector)
+{
+	kernel->synchDisk->FlushSector(sector);
+	int lv = whichLv(numBytes);
+	for (int i = 0; i < NUM_DIRECT; ++i)
+	{
+		if (dataSectors[i] == INVALID_SECTOR || (!lv && i >= numDataSectors))
+		{
+			break;
+		}
+		if (lv)
+		{
+			ASSERT(children[i]);
+			children[i]->Sync(dataSectors[i]);
+		}
+		else
+		{
+			kernel->synchDisk->FlushSector(dataSectors[i]);
+		}
+	}
+}
+
 //----------------------------------------------------------------------
 // FileHeader::ByteToSector
 // 	Return which disk sector is storing a particular byte within the file.
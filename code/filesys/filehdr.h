@@ -60,6 +60,8 @@ public:
 	void FetchFrom(int sectorNumber);
 	// Write modifications to file header  back to disk
 	void WriteBack(int sectorNumber);
+	// Make sure the disk has the latest header and data sectors of the file
+	void Sync(int sectorNumber);
 	// Convert a byte offset into the file to the disk sector containing the byte
 	int ByteToSector(int offset);
 	// Return the length of the file in bytes
@@ -51,6 +51,7 @@
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#include "remotefs.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known
@@ -79,6 +80,7 @@
 FileSystem::FileSystem(bool format)
 {
     DEBUG(dbgFile, "Initializing the file system.");
+    remote = NULL;
     if (format)
     {
         PersistentBitmap *freeMap = new PersistentBitmap(NumSectors);
@@ -137,11 +139,6 @@ FileSystem::FileSystem(bool format)
         freeMapFile = new OpenFile(FreeMapSector);
         directoryFile = new OpenFile(DirectorySector);
     }
-
-    for (int i = 0; i < FILE_OPEN_LIMIT; i++)
-    {
-        OpenFileTable[i] = NULL;
-    }
 }
 
 //----------------------------------------------------------------------
@@ -152,6 +149,7 @@ FileSystem::~FileSystem()
 {
     delete freeMapFile;
     delete directoryFile;
+    delete remote;
 }
 
 //----------------------------------------------------------------------
@@ -184,6 +182,10 @@ FileSystem::~FileSystem()
 //----------------------------------------------------------------------
 bool FileSystem::Create(char *name, int initialSize)
 {
+    if (remote != NULL)
+    {
+        return remote->Create(name, initialSize);
+    }
     return createFileOrDir(name, FILE, initialSize);
 }
 
@@ -194,17 +196,27 @@ bool FileSystem::Create(char *name, int initialSize)
 //	  Find the location of the file's header, using the directory
 //	  Bring the header into memory
 //
+//	Return NULL if the file does not exist.
+//
 //	"name" -- the text name of the file to be opened
 //----------------------------------------------------------------------
 OpenFile *FileSystem::Open(char *name)
 {
+    if (remote != NULL)
+    {
+        return remote->Exists(name) ? new OpenFile(remote, name) : NULL;
+    }
     FileFinder finder = FileFinder();
     finder.find(name, FILE, directoryFile);
     if (!finder.exist)
     {
         finder.find(name, DIR, directoryFile);
     }
-    ASSERT(finder.exist && finder.fhSector >= 0);
+    if (!finder.exist)
+    {
+        return NULL; // file not found
+    }
+    ASSERT(finder.fhSector >= 0);
     return new OpenFile(finder.fhSector);
 }
 
@@ -223,6 +235,10 @@ OpenFile *FileSystem::Open(char *name)
 //----------------------------------------------------------------------
 bool FileSystem::Remove(const char *name, bool recursive)
 {
+    if (remote != NULL)
+    {
+        return remote->Remove(name, recursive);
+    }
     if (recursive)
     {
         return recursivelyRemove(name);
@@ -362,62 +378,67 @@ void FileSystem::PrintHeader(char *name)
     delete hdr;
 }
 
-OpenFileId FileSystem::OpenAFile(char *name)
+//----------------------------------------------------------------------
+// FileSystem::CopyFileRange
+// 	Copy "size" bytes from the seek position of open file "in" to the
+//	seek position of open file "out", advancing both.  Return the
+//	number of bytes copied, which is short if either file ends first.
+//	"in" and "out" must be different open files.
+//
+//	The data moves in chunks of up to COPY_CHUNK_SECTORS sectors.  Each
+//	chunk ends on a sector boundary of the destination, so apart from
+//	the first and last chunk every write covers whole sectors and
+//	WriteAt never has to read a partial sector back in.
+//----------------------------------------------------------------------
+int FileSystem::CopyFileRange(OpenFile *in, OpenFile *out, int size)
 {
-    OpenFileId id;
-    for (id = 0; id < 20; ++id)
+    ASSERT(in != out);
+    char *buf = new char[COPY_CHUNK_SECTORS * SectorSize];
+    int copied = 0;
+
+    while (copied < size)
     {
-        if (OpenFileTable[id] == NULL)
+        int chunk = COPY_CHUNK_SECTORS * SectorSize - out->Tell() % SectorSize;
+        chunk = min(chunk, size - copied);
+        int numRead = in->Read(buf, chunk);
+        if (numRead <= 0)
         {
             break;
         }
+        int numWritten = out->Write(buf, numRead);
+        copied += numWritten;
+        if (numWritten < numRead)
+        {
+            // the destination ended; leave the source just past what we copied
+            in->Seek(in->Tell() - (numRead - numWritten));
+            break;
+        }
     }
-    // exceed the opened file limit
-    if (id == 20)
-    {
-        return -1;
-    }
-    OpenFileTable[id] = Open(name);
-    return id;
-}
-
-int FileSystem::WriteFile_(char *buffer, int size, OpenFileId id)
-{
-    if (buffer != NULL && size >= 0 && isValidFileId(id))
-    {
-        return OpenFileTable[id]->Write(buffer, size);
-    }
-    return -1;
-}
-
-int FileSystem::ReadFile(char *buffer, int size, OpenFileId id)
-{
-    if (buffer != NULL && size >= 0 && isValidFileId(id))
-    {
-        return OpenFileTable[id]->Read(buffer, size);
-    }
-    return -1;
+    delete[] buf;
+    return copied;
 }
 
-int FileSystem::CloseFile(OpenFileId id)
+bool FileSystem::Mkdir(char *name)
 {
-    if (isValidFileId(id))
+    if (remote != NULL)
     {
-        delete OpenFileTable[id];
-        OpenFileTable[id] = NULL;
-        return 1;
+        return remote->Mkdir(name);
     }
-    return -1;
-}
-
-bool FileSystem::isValidFileId(OpenFileId id)
-{
-    return id >= 0 && id < FILE_OPEN_LIMIT && OpenFileTable[id] != NULL;
+    return createFileOrDir(name, DIR, -1);
 }
 
-bool FileSystem::Mkdir(char *name)
+//----------------------------------------------------------------------
+// FileSystem::MountRemote
+// 	Use the file system of another machine: from now on Create, Open,
+//	Remove and Mkdir go there (see remotefs.h).  List, Print and
+//	PrintHeader still show the local disk.
+//
+//	"server" -- the machine exporting its file system
+//----------------------------------------------------------------------
+void FileSystem::MountRemote(int server)
 {
-    return createFileOrDir(name, DIR, -1);
+    ASSERT(remote == NULL);
+    remote = new RemoteFileSystem(server);
 }
 
 bool FileSystem::createFileOrDir(char *name, bool isDir, int initialSize)
@@ -40,7 +40,8 @@
 #include "pbitmap.h"
 
 #define PATH_NAME_MAX_LEN 256
-#define FILE_OPEN_LIMIT 20
+// Most sectors CopyFileRange moves per disk pass
+#define COPY_CHUNK_SECTORS 8
 
 typedef int OpenFileId;
 
@@ -81,6 +82,8 @@ public:
 };
 
 #else // FILESYS
+class RemoteFileSystem;
+
 class FileFinder
 {
 	friend class FileSystem;
@@ -113,11 +116,8 @@ public:
 	bool Create(char *name, int initialSize);
 	// Open a file (UNIX open)
 	OpenFile *Open(char *name);
-	// This function is used for kernel open system call
-	OpenFileId OpenAFile(char *name);
-	int WriteFile_(char *buffer, int size, OpenFileId id);
-	int ReadFile(char *buffer, int size, OpenFileId id);
-	int CloseFile(OpenFileId id);
+	// Copy between two open files without going through user memory
+	int CopyFileRange(OpenFile *in, OpenFile *out, int size);
 	// Delete a file (UNIX unlink)
 	bool Remove(const char *name, bool recursive);
 	// List all the files in the file system
@@ -126,14 +126,16 @@ public:
 	void Print();
 	void PrintHeader(char *name);
 	bool Mkdir(char *name);
+	// From now on, create, open, remove and make directories on the file system of machine "server"
+	void MountRemote(int server);
 
 private:
+	// Where paths are looked up, if on another machine, or NULL
+	RemoteFileSystem *remote;
 	// Bit map of free disk blocks, represented as a file
 	OpenFile *freeMapFile;
 	// "Root" directory -- list of file names, represented as a file
 	OpenFile *directoryFile;
-	OpenFile *OpenFileTable[FILE_OPEN_LIMIT];
-	bool isValidFileId(OpenFileId id);
 	/**
 	 * @brief Create a File Or Dir
 	 *
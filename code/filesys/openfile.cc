@@ -17,6 +17,7 @@
 #include "filehdr.h"
 #include "openfile.h"
 #include "synchdisk.h"
+#include "remotefs.h"
 
 //----------------------------------------------------------------------
 // OpenFile::OpenFile
@@ -29,7 +30,30 @@ OpenFile::OpenFile(int sector)
 {
     hdr = new FileHeader;
     hdr->FetchFrom(sector);
+    hdrSector = sector;
+    remote = NULL;
+    remoteName = NULL;
     seekPosition = 0;
+    refCount = 1;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::OpenFile
+// 	Open a file of a file system on another machine.  Reads and
+//	writes go to "remote", which caches what it can.
+//
+//	"remote" -- the file system the file is on
+//	"name" -- absolute path of the file there
+//----------------------------------------------------------------------
+OpenFile::OpenFile(RemoteFileSystem *remote, const char *name)
+{
+    hdr = NULL;
+    hdrSector = -1;
+    this->remote = remote;
+    remoteName = new char[strlen(name) + 1];
+    strcpy(remoteName, name);
+    seekPosition = 0;
+    refCount = 1;
 }
 
 //----------------------------------------------------------------------
@@ -39,6 +63,7 @@ OpenFile::OpenFile(int sector)
 OpenFile::~OpenFile()
 {
     delete hdr;
+    delete[] remoteName;
 }
 
 //----------------------------------------------------------------------
@@ -106,6 +131,11 @@ int OpenFile::Write(char *into, int numBytes)
 //----------------------------------------------------------------------
 int OpenFile::ReadAt(char *into, int numBytes, int position)
 {
+    if (remote != NULL)
+    {
+        return remote->ReadAt(remoteName, into, numBytes, position);
+    }
+
     int fileLength = hdr->FileLength();
     int i, firstSector, lastSector, numSectors;
     char *buf;
@@ -140,6 +170,11 @@ int OpenFile::ReadAt(char *into, int numBytes, int position)
 
 int OpenFile::WriteAt(char *from, int numBytes, int position)
 {
+    if (remote != NULL)
+    {
+        return remote->WriteAt(remoteName, from, numBytes, position);
+    }
+
     int fileLength = hdr->FileLength();
     int i, firstSector, lastSector, numSectors;
     bool firstAligned, lastAligned;
@@ -190,12 +225,30 @@ int OpenFile::WriteAt(char *from, int numBytes, int position)
     return numBytes;
 }
 
+//----------------------------------------------------------------------
+// OpenFile::Sync
+// 	Write this file's dirty header and data sectors out of the disk
+//	cache, leaving the rest of the cache alone.  Writes to a remote
+//	file are already on the server.
+//----------------------------------------------------------------------
+void OpenFile::Sync()
+{
+    if (remote == NULL)
+    {
+        hdr->Sync(hdrSector);
+    }
+}
+
 //----------------------------------------------------------------------
 // OpenFile::Length
 // 	Return the number of bytes in the file.
 //----------------------------------------------------------------------
 int OpenFile::Length()
 {
+    if (remote != NULL)
+    {
+        return remote->Length(remoteName);
+    }
     return hdr->FileLength();
 }
 
@@ -34,6 +34,7 @@ public:
 	{
 		file = f;
 		currentOffset = 0;
+		refCount = 1;
 	}							 // open the file
 	~OpenFile() { Close(file); } // close the file
 
@@ -67,23 +68,34 @@ public:
 		return Tell(file);
 	}
 
+	void Retain() { refCount++; }
+	bool Release() { return --refCount == 0; }
+
+	void Sync() {} // writes go straight to the UNIX file
+
 private:
 	int file;
 	int currentOffset;
+	int refCount;
 };
 
 #else // FILESYS
 class FileHeader;
+class RemoteFileSystem;
 
 class OpenFile
 {
 public:
 	// Open a file whose header is located at "sector" on the disk
 	OpenFile(int sector);
+	// Open file "name" of a file system on another machine
+	OpenFile(RemoteFileSystem *remote, const char *name);
 	// Close the file
 	~OpenFile();
 	// Set the position from which to start reading/writing -- UNIX lseek
 	void Seek(int position);
+	// Return the position the next Read/Write starts from -- UNIX tell
+	int Tell() { return seekPosition; }
 	// Read/write bytes from the file, starting at the implicit position. Return the # actually read/written, and increment position in file.
 	int Read(char *into, int numBytes);
 	int Write(char *from, int numBytes);
@@ -93,12 +105,27 @@ public:
 	int WriteAt(char *from, int numBytes, int position);
 	// Return the number of bytes in the file (this interface is simpler than the UNIX idiom -- lseek to end of file, tell, lseek back
 	int Length();
+	// Make sure everything written to the file is on disk -- UNIX fsync
+	void Sync();
+
+	// Count another user of this open file (see FileTable)
+	void Retain() { refCount++; }
+	// Drop a user; return TRUE if that was the last one, and the file should be deleted
+	bool Release() { return --refCount == 0; }
 
 private:
-	// Header for this file
+	// Header for this file; NULL if the file is remote
 	FileHeader *hdr;
+	// File system the file is on, if on another machine, or NULL
+	RemoteFileSystem *remote;
+	// Path of the file there
+	char *remoteName;
+	// Disk sector holding the header
+	int hdrSector;
 	// Current position within the file
 	int seekPosition;
+	// Number of users; starts at 1 for whoever opened the file
+	int refCount;
 };
 
 #endif // FILESYS
@@ -0,0 +1,147 @@
+// remotedisk.cc
+//	Routines for reading and writing the sectors of a disk that is
+//	attached to another Nachos machine.
+//
+//	The client sends a DiskRequest, followed by sector contents for
+//	writes, and waits for the reply.  The server answers requests one
+//	at a time, through its own SynchDisk, so its sector cache serves
+//	the client too.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "remotedisk.h"
+#include "synchdisk.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// RemoteDisk::RemoteDisk
+// 	Open a connection to the disk server on another machine.
+//
+//	"server" -- the machine exporting its disk
+//----------------------------------------------------------------------
+RemoteDisk::RemoteDisk(NetworkAddress server)
+{
+    conn = new ReliableConnection(kernel->postOfficeIn, kernel->postOfficeOut,
+                                  server, DiskClientBox, DiskServerBox);
+}
+
+//----------------------------------------------------------------------
+// RemoteDisk::ReadSectors
+// 	Read a batch of sectors from the server; return once they have
+//	all arrived.
+//
+//	"count" -- number of sectors, at most RemoteDiskBatch
+//	"sectors" -- which sectors to read
+//	"data" -- where to put them, one after another
+//----------------------------------------------------------------------
+void RemoteDisk::ReadSectors(int count, int *sectors, char *data)
+{
+    DiskRequest request;
+
+    ASSERT(count >= 0 && count <= RemoteDiskBatch);
+    request.type = DiskReadRequest;
+    request.count = count;
+    request.sync = FALSE;
+    memcpy(request.sectors, sectors, count * sizeof(int));
+
+    conn->Send((char *)&request, sizeof(request));
+    conn->ReceiveAll(data, count * SectorSize);
+    kernel->stats->numRemoteDiskRequests++;
+    kernel->stats->numRemoteSectorsRead += count;
+}
+
+//----------------------------------------------------------------------
+// RemoteDisk::WriteSectors
+// 	Send a batch of sectors to the server; return once the server
+//	has them.
+//
+//	"count" -- number of sectors, at most RemoteDiskBatch
+//	"sectors" -- which sectors to write
+//	"data" -- their new contents, one after another
+//	"sync" -- TRUE to have the server write its cache to disk too
+//----------------------------------------------------------------------
+void RemoteDisk::WriteSectors(int count, int *sectors, char *data, bool sync)
+{
+    DiskRequest request;
+    int done;
+
+    ASSERT(count >= 0 && count <= RemoteDiskBatch);
+    request.type = DiskWriteRequest;
+    request.count = count;
+    request.sync = sync;
+    memcpy(request.sectors, sectors, count * sizeof(int));
+
+    conn->Send((char *)&request, sizeof(request));
+    conn->Send(data, count * SectorSize);
+    conn->ReceiveAll((char *)&done, sizeof(done));
+    kernel->stats->numRemoteDiskRequests++;
+    kernel->stats->numRemoteSectorsWritten += count;
+}
+
+//----------------------------------------------------------------------
+// DiskServer::DiskServer
+// 	Export our disk to a client machine, and start the thread that
+//	answers its requests.
+//
+//	"client" -- the machine using our disk
+//----------------------------------------------------------------------
+DiskServer::DiskServer(NetworkAddress client)
+{
+    conn = new ReliableConnection(kernel->postOfficeIn, kernel->postOfficeOut,
+                                  client, DiskServerBox, DiskClientBox);
+
+    Thread *t = kernel->NewThread("disk server");
+    t->Fork(DiskServer::Serve, this);
+}
+
+//----------------------------------------------------------------------
+// DiskServer::Serve
+// 	Read requests off the connection and carry them out on
+//	kernel->synchDisk, one at a time.
+//----------------------------------------------------------------------
+void DiskServer::Serve(void *data)
+{
+    DiskServer *_this = (DiskServer *)data;
+    DiskRequest request;
+    char *sectors = new char[RemoteDiskBatch * SectorSize];
+    int done = 0;
+
+    for (;;)
+    {
+        _this->conn->ReceiveAll((char *)&request, sizeof(request));
+        ASSERT(request.count >= 0 && request.count <= RemoteDiskBatch);
+        for (int i = 0; i < request.count; i++)
+        {
+            ASSERT(request.sectors[i] >= 0 && request.sectors[i] < NumSectors);
+        }
+        DEBUG(dbgFile, "Remote disk request " << request.type << ", "
+                                               << request.count << " sectors");
+
+        if (request.type == DiskReadRequest)
+        {
+            for (int i = 0; i < request.count; i++)
+            {
+                kernel->synchDisk->ReadSector(request.sectors[i],
+                                              sectors + i * SectorSize);
+            }
+            _this->conn->Send(sectors, request.count * SectorSize);
+        }
+        else
+        {
+            _this->conn->ReceiveAll(sectors, request.count * SectorSize);
+            for (int i = 0; i < request.count; i++)
+            {
+                kernel->synchDisk->WriteSector(request.sectors[i],
+                                               sectors + i * SectorSize);
+            }
+            if (request.sync)
+            {
+                kernel->synchDisk->FlushAll();
+            }
+            _this->conn->Send((char *)&done, sizeof(done));
+        }
+    }
+}
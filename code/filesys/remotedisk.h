@@ -0,0 +1,86 @@
+// remotedisk.h
+//	Data structures for a disk on another machine, reached over the
+//	network.
+//
+//	One Nachos, the server, exports its own SynchDisk; another, the
+//	client, sends its sector reads and writes there instead of to a
+//	local DISK file.  Requests and replies travel over a reliable
+//	connection, so they survive an unreliable network.  The client's
+//	SynchDisk cache still sits in front of the remote disk, so only
+//	misses and write-backs cross the network; dirty sectors are
+//	written in batches where possible.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#ifndef REMOTEDISK_H
+#define REMOTEDISK_H
+
+#include "disk.h"
+#include "network.h"
+#include "transport.h"
+
+// Mailboxes at the two ends of the connection
+const int DiskServerBox = 4;
+const int DiskClientBox = 5;
+
+// Most sectors moved by one request
+const int RemoteDiskBatch = 8;
+
+enum DiskRequestType
+{
+    DiskReadRequest,
+    DiskWriteRequest
+};
+
+// The following class defines a request from client to server.  For
+// writes, the contents of the sectors follow it on the connection; for
+// reads, the server replies with the contents.  A write is answered
+// with a single int, once the server has the data.
+
+class DiskRequest
+{
+public:
+    int type;                     // DiskReadRequest or DiskWriteRequest
+    int count;                    // Number of sectors, may be 0
+    int sync;                     // Writes: also flush the server's
+                                  //   cache to its disk
+    int sectors[RemoteDiskBatch]; // Which sectors
+};
+
+// The client end: used by SynchDisk in place of the Disk device.
+// The caller serializes requests (SynchDisk holds its lock).
+
+class RemoteDisk
+{
+public:
+    RemoteDisk(NetworkAddress server); // Connect to the disk on "server"
+
+    void ReadSectors(int count, int *sectors, char *data);
+    // Read "count" sectors into "data"
+    void WriteSectors(int count, int *sectors, char *data, bool sync);
+    // Write "count" sectors from "data", and
+    // if "sync", make the server write them
+    // through to its disk
+
+private:
+    ReliableConnection *conn; // Carries requests and replies
+};
+
+// The server end: a thread that serves one client from kernel->synchDisk.
+
+class DiskServer
+{
+public:
+    DiskServer(NetworkAddress client); // Start serving "client"
+
+private:
+    ReliableConnection *conn; // Carries requests and replies
+
+    static void Serve(void *data); // Answer requests, forever
+};
+
+#endif // REMOTEDISK_H
@@ -0,0 +1,683 @@
+// remotefs.cc
+//	Routines for using files that live on another Nachos machine.
+//
+//	The client sends a FileRequest, the file's path and, for writes,
+//	the data, and waits for the reply.  What it learns is cached until
+//	the lease in the reply runs out; file blocks are fetched in runs
+//	of up to RemoteFileBatch bytes, and the least recently used files
+//	give up their blocks when the cache is full.
+//
+//	The server answers each client from its own thread, one request
+//	at a time over all clients, through kernel->fileSystem.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+#ifndef FILESYS_STUB
+
+#include "copyright.h"
+#include "remotefs.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// CachedFile::CachedFile
+// 	Start keeping track of a file.  Nothing is known about it until
+//	the server has been asked, so the lease has already expired.
+//
+//	"name" -- path of the file
+//----------------------------------------------------------------------
+CachedFile::CachedFile(const char *name)
+{
+    strcpy(path, name);
+    version = -1;
+    length = -1;
+    leaseExpires = 0;
+    numBlocks = 0;
+    blocks = NULL;
+    numCached = 0;
+}
+
+//----------------------------------------------------------------------
+// CachedFile::~CachedFile
+// 	De-allocate the cached blocks of a file.
+//----------------------------------------------------------------------
+CachedFile::~CachedFile()
+{
+    for (int i = 0; i < numBlocks; i++)
+    {
+        delete[] blocks[i];
+    }
+    delete[] blocks;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::RemoteFileSystem
+// 	Open a connection to the file server on another machine.
+//
+//	"server" -- the machine exporting its file system
+//----------------------------------------------------------------------
+RemoteFileSystem::RemoteFileSystem(NetworkAddress server)
+{
+    ASSERT(kernel->hostName >= 0 && kernel->hostName < MaxFileClients);
+    conn = new ReliableConnection(kernel->postOfficeIn, kernel->postOfficeOut,
+                                  server, FileClientBox,
+                                  FileServerBox + kernel->hostName);
+    lock = new Lock("remote file system lock");
+    cache = new List<CachedFile *>;
+    numCachedBlocks = 0;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::~RemoteFileSystem
+// 	Throw away everything we have cached.  As with the disk client,
+//	the connection is left to the helper threads.
+//----------------------------------------------------------------------
+RemoteFileSystem::~RemoteFileSystem()
+{
+    while (!cache->IsEmpty())
+    {
+        delete cache->RemoveFront();
+    }
+    delete cache;
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Create/Remove/Mkdir
+// 	Change the name space on the server; return TRUE if it worked.
+//	Whatever we had cached under the name is forgotten.  (Files below
+//	a directory removed with "recursive" are not; their leases run
+//	out instead.)
+//
+//	"name" -- absolute path of the file or directory
+//	"initialSize" -- size of the new file
+//	"recursive" -- remove a directory and all it contains
+//----------------------------------------------------------------------
+bool RemoteFileSystem::Create(const char *name, int initialSize)
+{
+    FileReply reply;
+
+    lock->Acquire();
+    Call(FileCreateRequest, name, 0, initialSize, NULL, &reply);
+    Forget(name);
+    lock->Release();
+    return reply.status;
+}
+
+bool RemoteFileSystem::Remove(const char *name, bool recursive)
+{
+    FileReply reply;
+
+    lock->Acquire();
+    Call(FileRemoveRequest, name, recursive, 0, NULL, &reply);
+    Forget(name);
+    lock->Release();
+    return reply.status;
+}
+
+bool RemoteFileSystem::Mkdir(const char *name)
+{
+    FileReply reply;
+
+    lock->Acquire();
+    Call(FileMkdirRequest, name, 0, 0, NULL, &reply);
+    Forget(name);
+    lock->Release();
+    return reply.status;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Exists/Length
+// 	Return whether a file exists, or its length in bytes (-1 if it
+//	doesn't exist).  Answered from the cache while the lease lasts.
+//
+//	"name" -- absolute path of the file
+//----------------------------------------------------------------------
+bool RemoteFileSystem::Exists(const char *name)
+{
+    return Length(name) >= 0;
+}
+
+int RemoteFileSystem::Length(const char *name)
+{
+    lock->Acquire();
+    int length = Lookup(name)->length;
+    lock->Release();
+    return length;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::ReadAt
+// 	Read part of a remote file.  Blocks we have cached are copied
+//	straight out of the cache; runs of missing blocks are fetched
+//	from the server, and kept.
+//
+//	Return the number of bytes read, which is short at the end of the
+//	file, or if the file goes away.
+//
+//	"name" -- absolute path of the file
+//	"into" -- the buffer to contain the data
+//	"numBytes" -- the number of bytes to read
+//	"position" -- the offset within the file of the first byte
+//----------------------------------------------------------------------
+int RemoteFileSystem::ReadAt(const char *name, char *into, int numBytes,
+                             int position)
+{
+    int copied = 0;
+
+    lock->Acquire();
+    CachedFile *file = Lookup(name);
+    if (numBytes > 0 && position >= 0 && position < file->length)
+    {
+        if (position + numBytes > file->length)
+        {
+            numBytes = file->length - position;
+        }
+        int last = divRoundDown(position + numBytes - 1, RemoteFileBlock);
+
+        while (copied < numBytes && position + copied < file->length)
+        {
+            int block = divRoundDown(position + copied, RemoteFileBlock);
+            int offset = (position + copied) % RemoteFileBlock;
+            int len = min(RemoteFileBlock - offset, numBytes - copied);
+
+            if (file->blocks[block] != NULL)
+            {
+                kernel->stats->numRemoteFileCacheHits++;
+            }
+            else if (!Fetch(file, block, last) || block >= file->numBlocks ||
+                     file->blocks[block] == NULL)
+            {
+                break; // the file was removed, or shrank
+            }
+            bcopy(file->blocks[block] + offset, into + copied, len);
+            copied += len;
+        }
+    }
+    lock->Release();
+    return copied;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::WriteAt
+// 	Write part of a remote file.  The data goes to the server before
+//	we return; any of its blocks we have cached are updated as well,
+//	unless the reply shows someone else changed the file too, in which
+//	case the cached blocks are dropped.
+//
+//	Return the number of bytes written; as with local files, writing
+//	never makes the file longer.
+//
+//	"name" -- absolute path of the file
+//	"from" -- the data to write
+//	"numBytes" -- the number of bytes to write
+//	"position" -- the offset within the file of the first byte
+//----------------------------------------------------------------------
+int RemoteFileSystem::WriteAt(const char *name, char *from, int numBytes,
+                              int position)
+{
+    FileReply reply;
+    int written = 0;
+
+    lock->Acquire();
+    CachedFile *file = Lookup(name);
+    if (numBytes > 0 && position >= 0 && position < file->length)
+    {
+        if (position + numBytes > file->length)
+        {
+            numBytes = file->length - position;
+        }
+        while (written < numBytes)
+        {
+            int start = position + written;
+            int chunk = min(numBytes - written, RemoteFileBatch);
+
+            Call(FileWriteRequest, name, start, chunk, from + written, &reply);
+            if (reply.version == file->version + 1)
+            {
+                file->version = reply.version; // only our own change
+            }
+            Update(file, &reply);
+            if (reply.status <= 0)
+            {
+                break;
+            }
+            for (int pos = start; pos < start + reply.status;)
+            {
+                int block = divRoundDown(pos, RemoteFileBlock);
+                int offset = pos % RemoteFileBlock;
+                int len = min(RemoteFileBlock - offset, start + reply.status - pos);
+
+                if (block < file->numBlocks && file->blocks[block] != NULL)
+                {
+                    bcopy(from + (pos - position), file->blocks[block] + offset, len);
+                }
+                pos += len;
+            }
+            written += reply.status;
+        }
+    }
+    lock->Release();
+    return written;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Call
+// 	Send one request to the server and wait for its reply.  The lock
+//	must be held, so requests and replies don't interleave on the
+//	connection.
+//
+//	"type" -- a FileRequestType
+//	"name" -- absolute path of the file
+//	"position", "length" -- see FileRequest
+//	"data" -- Write: the bytes to send; Read: where to put the bytes
+//		that come back
+//	"reply" -- where to put the server's answer
+//----------------------------------------------------------------------
+void RemoteFileSystem::Call(int type, const char *name, int position,
+                            int length, char *data, FileReply *reply)
+{
+    FileRequest request;
+
+    request.type = type;
+    request.position = position;
+    request.length = length;
+    request.pathLength = strlen(name);
+    ASSERT(request.pathLength > 0 && request.pathLength <= PATH_NAME_MAX_LEN);
+    DEBUG(dbgFile, "Remote file request " << type << " for " << name);
+
+    conn->Send((char *)&request, sizeof(request));
+    conn->Send((char *)name, request.pathLength);
+    if (type == FileWriteRequest)
+    {
+        conn->Send(data, length);
+    }
+    conn->ReceiveAll((char *)reply, sizeof(FileReply));
+    if (type == FileReadRequest && reply->status > 0)
+    {
+        ASSERT(reply->status <= length);
+        conn->ReceiveAll(data, reply->status);
+    }
+    kernel->stats->numRemoteFileRequests++;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Lookup
+// 	Find what we know about a file, starting to track it if it's new,
+//	and move it to the front of the cache.  Only RemoteCacheFiles files
+//	are tracked; a new one pushes out the least recently used.  If our lease on it has run
+//	out, ask the server for its current version first.
+//
+//	"name" -- absolute path of the file
+//----------------------------------------------------------------------
+CachedFile *RemoteFileSystem::Lookup(const char *name)
+{
+    CachedFile *file = NULL;
+    ListIterator<CachedFile *> iter(cache);
+
+    for (; !iter.IsDone(); iter.Next())
+    {
+        if (strcmp(iter.Item()->path, name) == 0)
+        {
+            file = iter.Item();
+            break;
+        }
+    }
+    if (file == NULL)
+    {
+        ASSERT(strlen(name) <= PATH_NAME_MAX_LEN);
+        if (cache->NumInList() >= (unsigned)RemoteCacheFiles)
+        {
+            CachedFile *oldest = NULL; // the last one on the list
+            ListIterator<CachedFile *> last(cache);
+
+            for (; !last.IsDone(); last.Next())
+            {
+                oldest = last.Item();
+            }
+            DropBlocks(oldest);
+            cache->Remove(oldest);
+            delete oldest;
+        }
+        file = new CachedFile(name);
+    }
+    else
+    {
+        cache->Remove(file);
+    }
+    cache->Prepend(file);
+
+    if (kernel->stats->totalTicks >= file->leaseExpires)
+    {
+        FileReply reply;
+
+        Call(FileStatRequest, name, 0, 0, NULL, &reply);
+        Update(file, &reply);
+    }
+    return file;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Update
+// 	Take in the attributes in a reply from the server, and renew the
+//	lease.  If the file isn't the version we have cached, its cached
+//	blocks are out of date; drop them.
+//
+//	"file" -- what we know about the file
+//	"reply" -- what the server just told us
+//----------------------------------------------------------------------
+void RemoteFileSystem::Update(CachedFile *file, FileReply *reply)
+{
+    if (reply->version != file->version || reply->fileLength != file->length)
+    {
+        DropBlocks(file);
+    }
+    if (reply->fileLength != file->length)
+    {
+        delete[] file->blocks;
+        file->numBlocks = divRoundUp(max(reply->fileLength, 0), RemoteFileBlock);
+        file->blocks = new char *[file->numBlocks];
+        memset(file->blocks, 0, file->numBlocks * sizeof(char *));
+    }
+    file->version = reply->version;
+    file->length = reply->fileLength;
+    file->leaseExpires = kernel->stats->totalTicks + reply->lease;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Forget
+// 	Stop tracking a file whose name we have just changed on the server.
+//
+//	"name" -- absolute path of the file
+//----------------------------------------------------------------------
+void RemoteFileSystem::Forget(const char *name)
+{
+    ListIterator<CachedFile *> iter(cache);
+
+    for (; !iter.IsDone(); iter.Next())
+    {
+        CachedFile *file = iter.Item();
+        if (strcmp(file->path, name) == 0)
+        {
+            DropBlocks(file);
+            cache->Remove(file);
+            delete file;
+            return;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::DropBlock
+// 	Throw away one cached block of a file, if we have it.
+//----------------------------------------------------------------------
+void RemoteFileSystem::DropBlock(CachedFile *file, int block)
+{
+    if (file->blocks[block] != NULL)
+    {
+        delete[] file->blocks[block];
+        file->blocks[block] = NULL;
+        file->numCached--;
+        numCachedBlocks--;
+    }
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::DropBlocks
+// 	Throw away the cached blocks of a file, keeping its attributes.
+//----------------------------------------------------------------------
+void RemoteFileSystem::DropBlocks(CachedFile *file)
+{
+    for (int i = 0; i < file->numBlocks; i++)
+    {
+        DropBlock(file, i);
+    }
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::MakeRoom
+// 	Drop cached blocks until "count" more fit in the cache.  The least
+//	recently used files lose all their blocks first; if "keep" is the
+//	only one with any left, it loses those outside the run being
+//	fetched, which the caller is about to fill in.
+//
+//	"keep" -- the file being fetched
+//	"first", "count" -- the run being fetched
+//----------------------------------------------------------------------
+void RemoteFileSystem::MakeRoom(CachedFile *keep, int first, int count)
+{
+    while (numCachedBlocks + count > RemoteCacheBlocks)
+    {
+        CachedFile *victim = NULL;
+        ListIterator<CachedFile *> iter(cache);
+
+        for (; !iter.IsDone(); iter.Next())
+        {
+            if (iter.Item() != keep && iter.Item()->numCached > 0)
+            {
+                victim = iter.Item(); // the last one is the oldest
+            }
+        }
+        if (victim == NULL)
+        {
+            break;
+        }
+        DropBlocks(victim);
+    }
+    for (int i = 0; i < keep->numBlocks &&
+                    numCachedBlocks + count > RemoteCacheBlocks;
+         i++)
+    {
+        if (i < first || i >= first + count)
+        {
+            DropBlock(keep, i);
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Fetch
+// 	Read the run of uncached blocks starting at "first" from the
+//	server with one request, and cache them.  The run stops at a
+//	block we already have, at "last", or at RemoteFileBatch bytes.
+//
+//	Room is made for the run before it is filled in (see MakeRoom), so
+//	none of it is dropped before the caller has copied it out.
+//
+//	Return FALSE if the file no longer exists.
+//
+//	"file" -- what we know about the file
+//	"first", "last" -- the blocks wanted
+//----------------------------------------------------------------------
+bool RemoteFileSystem::Fetch(CachedFile *file, int first, int last)
+{
+    FileReply reply;
+    char *data = new char[RemoteFileBatch];
+    int count = 0;
+
+    while (first + count <= last && (count + 1) * RemoteFileBlock <= RemoteFileBatch &&
+           file->blocks[first + count] == NULL)
+    {
+        count++;
+    }
+    Call(FileReadRequest, file->path, first * RemoteFileBlock,
+         count * RemoteFileBlock, data, &reply);
+    Update(file, &reply);
+
+    if (reply.status > 0)
+    {
+        MakeRoom(file, first, count);
+    }
+    for (int i = 0; i < count && first + i < file->numBlocks &&
+                    i * RemoteFileBlock < reply.status;
+         i++)
+    {
+        if (file->blocks[first + i] == NULL)
+        {
+            int len = min(RemoteFileBlock, reply.status - i * RemoteFileBlock);
+
+            file->blocks[first + i] = new char[RemoteFileBlock];
+            memset(file->blocks[first + i], 0, RemoteFileBlock);
+            bcopy(data + i * RemoteFileBlock, file->blocks[first + i], len);
+            file->numCached++;
+            numCachedBlocks++;
+            kernel->stats->numRemoteFileBlocksFetched++;
+        }
+    }
+    delete[] data;
+    return reply.status >= 0;
+}
+
+//----------------------------------------------------------------------
+// FileServer::FileServer
+// 	Export our file system to a client machine, and start the thread
+//	that answers its requests.
+//
+//	"client" -- the machine using our files
+//----------------------------------------------------------------------
+Lock *FileServer::lock = NULL;
+List<FileVersion *> *FileServer::versions = NULL;
+
+FileServer::FileServer(NetworkAddress client)
+{
+    ASSERT(client >= 0 && client < MaxFileClients);
+    conn = new ReliableConnection(kernel->postOfficeIn, kernel->postOfficeOut,
+                                  client, FileServerBox + client, FileClientBox);
+    if (lock == NULL)
+    {
+        lock = new Lock("file server lock");
+        versions = new List<FileVersion *>;
+    }
+
+    Thread *t = kernel->NewThread("file server");
+    t->Fork(FileServer::Serve, this);
+}
+
+//----------------------------------------------------------------------
+// FileServer::Serve
+// 	Read requests off the connection, carry them out, and send back
+//	the replies.
+//----------------------------------------------------------------------
+void FileServer::Serve(void *data)
+{
+    FileServer *_this = (FileServer *)data;
+    FileRequest request;
+    FileReply reply;
+    char path[PATH_NAME_MAX_LEN + 1];
+    char *buf = new char[RemoteFileBatch];
+
+    for (;;)
+    {
+        _this->conn->ReceiveAll((char *)&request, sizeof(request));
+        ASSERT(request.pathLength > 0 && request.pathLength <= PATH_NAME_MAX_LEN);
+        _this->conn->ReceiveAll(path, request.pathLength);
+        path[request.pathLength] = '\0';
+        if (request.type == FileReadRequest || request.type == FileWriteRequest)
+        {
+            ASSERT(request.length >= 0 && request.length <= RemoteFileBatch);
+        }
+        if (request.type == FileWriteRequest)
+        {
+            _this->conn->ReceiveAll(buf, request.length);
+        }
+        DEBUG(dbgFile, "Remote file request " << request.type << " for " << path);
+
+        lock->Acquire();
+        Perform(&request, path, buf, &reply);
+        lock->Release();
+
+        _this->conn->Send((char *)&reply, sizeof(reply));
+        if (request.type == FileReadRequest && reply.status > 0)
+        {
+            _this->conn->Send(buf, reply.status);
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// FileServer::Perform
+// 	Carry out a request on kernel->fileSystem, and fill in the reply
+//	with the result and the file's attributes afterwards.
+//
+//	"request" -- what the client asked for
+//	"path" -- the file it names
+//	"data" -- Write: the bytes to write; Read: where to put the bytes
+//	"reply" -- the answer to send back
+//----------------------------------------------------------------------
+void FileServer::Perform(FileRequest *request, char *path, char *data,
+                         FileReply *reply)
+{
+    bool changed = FALSE;
+
+    switch (request->type)
+    {
+    case FileCreateRequest:
+        reply->status = kernel->fileSystem->Create(path, request->length);
+        changed = reply->status;
+        break;
+    case FileRemoveRequest:
+        reply->status = kernel->fileSystem->Remove(path, request->position);
+        changed = reply->status;
+        break;
+    case FileMkdirRequest:
+        reply->status = kernel->fileSystem->Mkdir(path);
+        changed = reply->status;
+        break;
+    }
+
+    OpenFile *file = kernel->fileSystem->Open(path);
+    reply->fileLength = (file == NULL) ? -1 : file->Length();
+    switch (request->type)
+    {
+    case FileStatRequest:
+        reply->status = (file != NULL);
+        break;
+    case FileReadRequest:
+        reply->status = (file == NULL) ? -1 : file->ReadAt(data, request->length, request->position);
+        break;
+    case FileWriteRequest:
+        reply->status = (file == NULL) ? -1 : file->WriteAt(data, request->length, request->position);
+        changed = (reply->status > 0);
+        break;
+    }
+    delete file;
+
+    reply->version = Version(path, changed);
+    reply->lease = FileLeaseTime;
+}
+
+//----------------------------------------------------------------------
+// FileServer::Version
+// 	Return the version of a path: the number of times clients have
+//	changed it.  Paths no client has touched are at version 0.
+//
+//	"path" -- absolute path of the file
+//	"changed" -- a client just changed it; count the change first
+//----------------------------------------------------------------------
+int FileServer::Version(const char *path, bool changed)
+{
+    ListIterator<FileVersion *> iter(versions);
+
+    for (; !iter.IsDone(); iter.Next())
+    {
+        if (strcmp(iter.Item()->path, path) == 0)
+        {
+            if (changed)
+            {
+                iter.Item()->version++;
+            }
+            return iter.Item()->version;
+        }
+    }
+    if (!changed)
+    {
+        return 0;
+    }
+    FileVersion *entry = new FileVersion;
+    strcpy(entry->path, path);
+    entry->version = 1;
+    versions->Append(entry);
+    return entry->version;
+}
+
+#endif // FILESYS_STUB
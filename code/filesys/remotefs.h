@@ -0,0 +1,195 @@
+// remotefs.h
+//	Data structures for using the file system of another machine,
+//	file by file, over the network.
+//
+//	One Nachos, the server, runs a thread per client that carries out
+//	path-based requests (stat, read, write, create, remove, mkdir) on
+//	its own FileSystem.  A client FileSystem sends those operations
+//	there instead of to its local disk.  Requests and replies travel
+//	over reliable connections, so several clients can share one file
+//	system through an unreliable network.
+//
+//	The client caches what it learns about each file -- whether it
+//	exists, its length, and blocks of its contents -- under a lease
+//	granted by the server.  While the lease runs, reads are answered
+//	from the cache without any network traffic.  Once it expires, the
+//	next use of the file asks the server for the file's version, and
+//	the cached blocks are kept only if nothing has changed.  Writes go
+//	through to the server at once.
+//
+//	Leases are only timed: the server does not call them back, so a
+//	client may read stale data for up to FileLeaseTime ticks after
+//	another client writes.  The server counts versions only for the
+//	changes it makes on behalf of clients; programs running on the
+//	server itself should not write shared files.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#ifndef REMOTEFS_H
+#define REMOTEFS_H
+
+#include "disk.h"
+#include "filesys.h"
+#include "list.h"
+#include "network.h"
+#include "synch.h"
+#include "transport.h"
+
+// Mailboxes: the client always uses FileClientBox; the server uses a
+// separate mailbox, FileServerBox + the client's machine id, for each
+// client it serves.
+const int FileClientBox = 6;
+const int FileServerBox = 8;
+const int MaxFileClients = 8;
+
+// Unit of client caching, and the most bytes moved by one request
+const int RemoteFileBlock = SectorSize;
+const int RemoteFileBatch = 8 * RemoteFileBlock;
+
+// Most blocks a client keeps cached, over all files
+const int RemoteCacheBlocks = 128;
+
+// Most files a client keeps track of; the least recently used one is
+// forgotten to make room for another
+const int RemoteCacheFiles = 64;
+
+// Ticks a client may trust what the server told it about a file
+const int FileLeaseTime = 100 * TimerTicks;
+
+enum FileRequestType
+{
+    FileStatRequest,
+    FileReadRequest,
+    FileWriteRequest,
+    FileCreateRequest,
+    FileRemoveRequest,
+    FileMkdirRequest
+};
+
+// The following class defines a request from client to server.  The
+// path of the file follows it on the connection, without the '\0';
+// for writes, "length" bytes of data follow the path.
+
+class FileRequest
+{
+public:
+    int type;       // a FileRequestType
+    int position;   // Read, Write: offset in the file;
+                    //   Remove: recursive?
+    int length;     // Read, Write: bytes to move;
+                    //   Create: initial size
+    int pathLength; // Bytes in the path
+};
+
+// The server's answer.  For reads, "status" bytes of data follow it.
+
+class FileReply
+{
+public:
+    int status;     // Read, Write: bytes moved, or -1 if there is no
+                    //   such file; others: TRUE or FALSE
+    int version;    // Changes every time a client changes the file
+    int fileLength; // Bytes in the file, or -1 if there is no such file
+    int lease;      // Ticks this reply can be trusted for
+};
+
+// What a client knows about one file.
+
+class CachedFile
+{
+public:
+    CachedFile(const char *name); // Nothing known yet
+    ~CachedFile();                // De-allocate the cached blocks
+
+    char path[PATH_NAME_MAX_LEN + 1];
+    int version;      // Server's version of the file
+    int length;       // Bytes in the file, -1 if it doesn't exist
+    int leaseExpires; // Tick after which we must ask again
+    int numBlocks;    // Entries in "blocks"
+    char **blocks;    // Cached file blocks, NULL where not cached
+    int numCached;    // Blocks not NULL
+};
+
+// The client end: used by FileSystem in place of the local disk.
+
+class RemoteFileSystem
+{
+public:
+    RemoteFileSystem(NetworkAddress server); // Use the files on "server"
+    ~RemoteFileSystem();                     // Forget the cache
+
+    bool Create(const char *name, int initialSize);
+    bool Remove(const char *name, bool recursive);
+    bool Mkdir(const char *name);
+    bool Exists(const char *name);
+
+    int Length(const char *name);
+    int ReadAt(const char *name, char *into, int numBytes, int position);
+    int WriteAt(const char *name, char *from, int numBytes, int position);
+
+private:
+    ReliableConnection *conn;   // Carries requests and replies
+    Lock *lock;                 // One request at a time; protects
+                                //   the cache
+    List<CachedFile *> *cache;  // Known files, most recently used first
+    int numCachedBlocks;        // Blocks cached, over all files
+
+    void Call(int type, const char *name, int position, int length,
+              char *data, FileReply *reply);
+    // Send a request and wait for the reply
+    CachedFile *Lookup(const char *name);
+    // Attributes of a file, asking the server
+    // if our lease has run out
+    void Update(CachedFile *file, FileReply *reply);
+    // Record a reply; drop cached blocks
+    // if the file has changed
+    void Forget(const char *name);
+    // Drop everything known about a file
+    void DropBlock(CachedFile *file, int block);
+    // Drop one cached block
+    void DropBlocks(CachedFile *file);
+    // Drop a file's cached blocks
+    void MakeRoom(CachedFile *keep, int first, int count);
+    // Drop blocks until "count" more fit,
+    // sparing the run being fetched
+    bool Fetch(CachedFile *file, int first, int last);
+    // Cache a run of missing blocks
+};
+
+// A path and the number of client changes made to it, kept by the server.
+
+class FileVersion
+{
+public:
+    char path[PATH_NAME_MAX_LEN + 1];
+    int version;
+};
+
+// The server end: a thread that serves one client from kernel->fileSystem.
+
+class FileServer
+{
+public:
+    FileServer(NetworkAddress client); // Start serving "client"
+
+private:
+    ReliableConnection *conn; // Carries requests and replies
+
+    static Lock *lock;                  // One request at a time, over
+                                        //   all clients
+    static List<FileVersion *> *versions; // Paths changed by clients
+
+    static void Serve(void *data); // Answer requests, forever
+    static void Perform(FileRequest *request, char *path, char *data,
+                        FileReply *reply);
+    // Carry out one request
+    static int Version(const char *path, bool changed);
+    // Version of a path, after bumping it
+    // if "changed"
+};
+
+#endif // REMOTEFS_H
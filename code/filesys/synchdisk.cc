@@ -16,29 +16,56 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "main.h"
+#include "remotedisk.h"
 
 //----------------------------------------------------------------------
 // SynchDisk::SynchDisk
 // 	Initialize the synchronous interface to the physical disk, in turn
-//	initializing the physical disk.
+//	initializing the physical disk, or connecting to the machine
+//	that has it (see the -dr flag).  The cache starts out empty.
 //
 //----------------------------------------------------------------------
-
 SynchDisk::SynchDisk()
 {
     semaphore = new Semaphore("synch disk", 0);
     lock = new Lock("synch disk lock");
-    disk = new Disk(this);
+    if (kernel->remoteDiskHost >= 0)
+    {
+        disk = NULL;
+        remote = new RemoteDisk(kernel->remoteDiskHost);
+    }
+    else
+    {
+        disk = new Disk(this);
+        remote = NULL;
+    }
+    for (int i = 0; i < DiskCacheSize; i++)
+    {
+        cache[i].sector = -1;
+        cache[i].dirty = FALSE;
+        cache[i].lastUse = 0;
+    }
+    useClock = 0;
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::~SynchDisk
 // 	De-allocate data structures needed for the synchronous disk
-//	abstraction.
+//	abstraction.  Nachos is halting, so there is no waiting for disk
+//	interrupts any more: dirty sectors are written straight out.
+//	For a remote disk that isn't possible; main and SysHalt have
+//	flushed it.
 //----------------------------------------------------------------------
-
 SynchDisk::~SynchDisk()
 {
+    for (int i = 0; i < DiskCacheSize && disk != NULL; i++)
+    {
+        if (cache[i].dirty)
+        {
+            disk->WriteNow(cache[i].sector, cache[i].data);
+        }
+    }
     delete disk;
     delete lock;
     delete semaphore;
@@ -52,30 +79,228 @@ SynchDisk::~SynchDisk()
 //	"sectorNumber" -- the disk sector to read
 //	"data" -- the buffer to hold the contents of the disk sector
 //----------------------------------------------------------------------
-
 void SynchDisk::ReadSector(int sectorNumber, char *data)
 {
     lock->Acquire(); // only one disk I/O at a time
-    disk->ReadRequest(sectorNumber, data);
-    semaphore->P(); // wait for interrupt
+    CachedSector *entry = Lookup(sectorNumber);
+    if (entry != NULL)
+    {
+        kernel->stats->numDiskCacheHits++;
+    }
+    else
+    {
+        entry = Replace(sectorNumber);
+        DiskRead(sectorNumber, entry->data);
+    }
+    memcpy(data, entry->data, SectorSize);
     lock->Release();
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::WriteSector
-// 	Write the contents of a buffer into a disk sector.  Return only
-//	after the data has been written.
+// 	Write the contents of a buffer into a disk sector.  The new
+//	contents go into the cache, and reach the disk later.
 //
 //	"sectorNumber" -- the disk sector to be written
 //	"data" -- the new contents of the disk sector
 //----------------------------------------------------------------------
-
 void SynchDisk::WriteSector(int sectorNumber, char *data)
 {
     lock->Acquire(); // only one disk I/O at a time
+    CachedSector *entry = Lookup(sectorNumber);
+    if (entry == NULL)
+    {
+        entry = Replace(sectorNumber); // no need to read it, we
+                                       // overwrite all of it
+    }
+    memcpy(entry->data, data, SectorSize);
+    entry->dirty = TRUE;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::FlushSector
+// 	Make sure the disk has the latest contents of a sector.  For a
+//	remote disk, the server writes it through to its own disk too.
+//
+//	"sectorNumber" -- the disk sector to write out
+//----------------------------------------------------------------------
+void SynchDisk::FlushSector(int sectorNumber)
+{
+    lock->Acquire();
+    CachedSector *entry = Lookup(sectorNumber);
+    if (remote != NULL)
+    { // have the server write it through to its disk, too
+        int count = (entry != NULL && entry->dirty) ? 1 : 0;
+        if (count > 0)
+        {
+            entry->dirty = FALSE;
+        }
+        remote->WriteSectors(count, &sectorNumber,
+                             (entry != NULL) ? entry->data : NULL, TRUE);
+    }
+    else if (entry != NULL && entry->dirty)
+    {
+        WriteBack(entry);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::FlushAll
+// 	Write every dirty sector to disk, in order of sector number so
+//	that the disk head sweeps across once.
+//----------------------------------------------------------------------
+void SynchDisk::FlushAll()
+{
+    if (remote != NULL)
+    {
+        FlushRemote();
+        return;
+    }
+    lock->Acquire();
+    while (TRUE)
+    {
+        CachedSector *next = NULL;
+        for (int i = 0; i < DiskCacheSize; i++)
+        {
+            if (cache[i].dirty && (next == NULL || cache[i].sector < next->sector))
+            {
+                next = &cache[i];
+            }
+        }
+        if (next == NULL)
+        {
+            break;
+        }
+        WriteBack(next);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::FlushRemote
+// 	Send every dirty sector to the remote disk, in order of sector
+//	number, RemoteDiskBatch sectors to a request.  The last request
+//	(even an empty one) asks the server to write through to its own
+//	disk.
+//----------------------------------------------------------------------
+void SynchDisk::FlushRemote()
+{
+    int sectors[RemoteDiskBatch];
+    char data[RemoteDiskBatch * SectorSize];
+    int lastSector = -1;
+    bool more = TRUE;
+
+    lock->Acquire();
+    while (more)
+    {
+        int count = 0;
+        while (count < RemoteDiskBatch)
+        {
+            CachedSector *next = NULL;
+            for (int i = 0; i < DiskCacheSize; i++)
+            {
+                if (cache[i].dirty && cache[i].sector > lastSector &&
+                    (next == NULL || cache[i].sector < next->sector))
+                {
+                    next = &cache[i];
+                }
+            }
+            if (next == NULL)
+            {
+                break;
+            }
+            next->dirty = FALSE;
+            sectors[count] = next->sector;
+            memcpy(data + count * SectorSize, next->data, SectorSize);
+            lastSector = next->sector;
+            count++;
+        }
+        more = (count == RemoteDiskBatch);
+        remote->WriteSectors(count, sectors, data, !more);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Lookup
+// 	Return the cache entry holding "sectorNumber", or NULL.
+//----------------------------------------------------------------------
+CachedSector *SynchDisk::Lookup(int sectorNumber)
+{
+    for (int i = 0; i < DiskCacheSize; i++)
+    {
+        if (cache[i].sector == sectorNumber)
+        {
+            cache[i].lastUse = ++useClock;
+            return &cache[i];
+        }
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Replace
+// 	Pick the least recently used cache entry (an empty one if there
+//	is one), write it back if it is dirty, and give it to
+//	"sectorNumber".  The caller fills in the data.
+//----------------------------------------------------------------------
+CachedSector *SynchDisk::Replace(int sectorNumber)
+{
+    CachedSector *victim = &cache[0];
+    for (int i = 1; i < DiskCacheSize; i++)
+    {
+        if (cache[i].lastUse < victim->lastUse)
+        {
+            victim = &cache[i];
+        }
+    }
+    if (victim->dirty)
+    {
+        WriteBack(victim);
+    }
+    victim->sector = sectorNumber;
+    victim->lastUse = ++useClock;
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteBack
+// 	Write a dirty cache entry to disk; it is clean afterwards.
+//----------------------------------------------------------------------
+void SynchDisk::WriteBack(CachedSector *entry)
+{
+    ASSERT(entry->dirty);
+    entry->dirty = FALSE;
+    DiskWrite(entry->sector, entry->data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::DiskRead/DiskWrite
+// 	Send one request to the disk and wait for the interrupt, or for
+//	the remote disk's reply.  The caller holds the lock.
+//----------------------------------------------------------------------
+void SynchDisk::DiskRead(int sectorNumber, char *data)
+{
+    if (remote != NULL)
+    {
+        remote->ReadSectors(1, &sectorNumber, data);
+        return;
+    }
+    disk->ReadRequest(sectorNumber, data);
+    semaphore->P(); // wait for interrupt
+}
+
+void SynchDisk::DiskWrite(int sectorNumber, char *data)
+{
+    if (remote != NULL)
+    {
+        remote->WriteSectors(1, &sectorNumber, data, FALSE);
+        return;
+    }
     disk->WriteRequest(sectorNumber, data);
     semaphore->P(); // wait for interrupt
-    lock->Release();
 }
 
 //----------------------------------------------------------------------
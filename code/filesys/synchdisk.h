@@ -15,6 +15,8 @@
 #include "synch.h"
 #include "callback.h"
 
+class RemoteDisk;
+
 // The following class defines a "synchronous" disk abstraction.
 // As with other I/O devices, the raw physical disk is an asynchronous device --
 // requests to read or write portions of the disk return immediately,
@@ -25,32 +27,76 @@
 // This class provides the abstraction that for any individual thread
 // making a request, it waits around until the operation finishes before
 // returning.
+//
+// Recently used sectors are kept in a small write-back cache.  Writes
+// only update the cache; a dirty sector goes to disk when it is evicted,
+// or when someone asks for it with FlushSector or FlushAll (see the
+// Fsync and Sync system calls), or when Nachos halts.
+//
+// The disk itself may be on another machine (see remotedisk.h); then
+// misses and write-backs go over the network, and FlushAll sends the
+// dirty sectors in batches.  Halting can't wait for the network, so
+// dirty sectors of a remote disk must be flushed before then: main does
+// it after the file system commands, and SysHalt before halting.
+
+// Number of sectors kept in the cache
+const int DiskCacheSize = 32;
+
+class CachedSector
+{
+public:
+    int sector;            // which sector is cached, -1 if none
+    bool dirty;            // newer than the copy on disk?
+    int lastUse;           // for picking the least recently used
+    char data[SectorSize]; // contents of the sector
+};
 
 class SynchDisk : public CallBackObj
 {
 public:
     SynchDisk();  // Initialize a synchronous disk,
                   // by initializing the raw Disk.
-    ~SynchDisk(); // De-allocate the synch disk data
+    ~SynchDisk(); // De-allocate the synch disk data,
+                  // writing out any dirty sectors
 
     void ReadSector(int sectorNumber, char *data);
     // Read/write a disk sector, returning
     // only once the data is actually read
-    // or written.  These call
-    // Disk::ReadRequest/WriteRequest and
-    // then wait until the request is done.
+    // or written (into the cache, for writes).
+    // These call Disk::ReadRequest/WriteRequest
+    // and then wait until the request is done.
     void WriteSector(int sectorNumber, char *data);
 
+    void FlushSector(int sectorNumber);
+    // Write the sector to disk if the cache has
+    // a dirty copy of it
+    void FlushAll(); // Write every dirty sector to disk
+
     void CallBack(); // Called by the disk device interrupt
                      // handler, to signal that the
                      // current disk operation is complete.
 
 private:
-    Disk *disk;           // Raw disk device
+    Disk *disk;           // Raw disk device, if local
+    RemoteDisk *remote;   // Disk on another machine, else NULL
     Semaphore *semaphore; // To synchronize requesting thread
                           // with the interrupt handler
     Lock *lock;           // Only one read/write request
                           // can be sent to the disk at a time
+                          // (and protects the cache)
+    CachedSector cache[DiskCacheSize];
+    int useClock;         // bumped on every cache access
+
+    CachedSector *Lookup(int sectorNumber); // NULL if not cached
+    CachedSector *Replace(int sectorNumber);
+    // Free up the least recently used entry
+    // for sectorNumber, writing it back first
+    // if it is dirty
+    void WriteBack(CachedSector *entry); // Write a dirty entry to disk
+    void FlushRemote();  // FlushAll, in batches, for a remote disk
+    void DiskRead(int sectorNumber, char *data);
+    void DiskWrite(int sectorNumber, char *data);
+    // Do one disk request and wait for it
 };
 
 #endif // SYNCHDISK_H
@@ -32,6 +32,9 @@
 #include <sys/file.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <cerrno>
 
 #ifdef SOLARIS
@@ -569,3 +572,152 @@ SendToSocket(int sockID, char *buffer, int packetSize, char *toName)
     // This may mask other kinds of failures, but it is the
     // right thing to do in the common case.
 }
+
+//----------------------------------------------------------------------
+// ReadBatchFromSocket
+// 	Read up to "maxPackets" fixed size packets off the IPC port, one
+//	into each of "buffers", without waiting.  On Linux this is a
+//	single recvmmsg call, rather than a poll and a read per packet.
+//	Abort on error.
+//
+//	Returns the number of packets read; 0 if none were waiting.
+//----------------------------------------------------------------------
+int
+ReadBatchFromSocket(int sockID, char **buffers, int packetSize, int maxPackets)
+{
+    ASSERT(maxPackets <= MaxSocketBatch);
+#ifdef LINUX
+    struct mmsghdr msgs[MaxSocketBatch];
+    struct iovec iovs[MaxSocketBatch];
+    int retVal;
+
+    bzero(msgs, sizeof(msgs));
+    for (int i = 0; i < maxPackets; i++) {
+	iovs[i].iov_base = buffers[i];
+	iovs[i].iov_len = packetSize;
+	msgs[i].msg_hdr.msg_iov = &iovs[i];
+	msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    retVal = recvmmsg(sockID, msgs, maxPackets, MSG_DONTWAIT, NULL);
+    if (retVal < 0) {
+	if (errno == EAGAIN || errno == EWOULDBLOCK) {
+	    return 0;
+	}
+	perror("in recvmmsg");
+    }
+    ASSERT(retVal >= 0);
+    for (int i = 0; i < retVal; i++) {
+	ASSERT((int) msgs[i].msg_len == packetSize);
+    }
+    return retVal;
+#else
+    int numRead = 0;
+
+    while (numRead < maxPackets && PollSocket(sockID)) {
+	ReadFromSocket(sockID, buffers[numRead], packetSize);
+	numRead++;
+    }
+    return numRead;
+#endif
+}
+
+//----------------------------------------------------------------------
+// SendBatchToSocket
+// 	Transmit "numPackets" fixed size packets, each to the IPC port
+//	named in "toNames".  On Linux they go out in a single sendmmsg
+//	call; any that it fails to send are retried one at a time by
+//	SendToSocket, which drops them if the target has gone away.
+//----------------------------------------------------------------------
+void
+SendBatchToSocket(int sockID, char **buffers, int packetSize, char **toNames,
+			int numPackets)
+{
+    int numSent = 0;
+
+    ASSERT(numPackets <= MaxSocketBatch);
+#ifdef LINUX
+    struct mmsghdr msgs[MaxSocketBatch];
+    struct iovec iovs[MaxSocketBatch];
+    struct sockaddr_un uNames[MaxSocketBatch];
+
+    bzero(msgs, sizeof(msgs));
+    for (int i = 0; i < numPackets; i++) {
+	InitSocketName(&uNames[i], toNames[i]);
+	iovs[i].iov_base = buffers[i];
+	iovs[i].iov_len = packetSize;
+	msgs[i].msg_hdr.msg_name = &uNames[i];
+	msgs[i].msg_hdr.msg_namelen = sizeof(uNames[i]);
+	msgs[i].msg_hdr.msg_iov = &iovs[i];
+	msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    numSent = sendmmsg(sockID, msgs, numPackets, 0);
+    if (numSent < 0) {
+	numSent = 0;
+    }
+#endif
+    for (; numSent < numPackets; numSent++) {
+	SendToSocket(sockID, buffers[numSent], packetSize, toNames[numSent]);
+    }
+}
+
+//----------------------------------------------------------------------
+// MapSharedFile
+// 	Map a file into memory, shared with any other process that maps
+//	it, so that Nachos running on the same host can exchange packets
+//	without a system call per packet.
+//
+//	If "create" is TRUE, the file is created (or emptied) and sized to
+//	"size" bytes of zeroes.  Otherwise it must already exist at full
+//	size; if it doesn't, return NULL.
+//----------------------------------------------------------------------
+
+char *
+MapSharedFile(char *name, int size, bool create)
+{
+    struct stat info;
+    void *addr;
+    int fd;
+
+    if (create) {
+	fd = open(name, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	ASSERT(fd >= 0);
+	ASSERT(ftruncate(fd, size) == 0);
+    } else {
+	fd = open(name, O_RDWR);
+	if (fd < 0) {
+	    return NULL;
+	}
+	if (fstat(fd, &info) < 0 || info.st_size < size) {
+	    close(fd);			// not set up yet
+	    return NULL;
+	}
+    }
+    addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);				// the mapping stays
+    ASSERT(addr != MAP_FAILED);
+    return (char *) addr;
+}
+
+//----------------------------------------------------------------------
+// UnmapSharedFile
+// 	Undo MapSharedFile.  The file itself is left alone.
+//----------------------------------------------------------------------
+
+void
+UnmapSharedFile(char *addr, int size)
+{
+    (void) munmap(addr, size);
+}
+
+//----------------------------------------------------------------------
+// MemoryBarrier
+// 	Keep the host CPU and compiler from reordering memory accesses
+//	across this point, so that another process reading shared memory
+//	sees our writes in the order we made them.
+//----------------------------------------------------------------------
+
+void
+MemoryBarrier()
+{
+    __sync_synchronize();
+}
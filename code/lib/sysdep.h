@@ -71,5 +71,16 @@ extern void DeAssignNameToSocket(char *socketName);
 extern bool PollSocket(int sockID);
 extern void ReadFromSocket(int sockID, char *buffer, int packetSize);
 extern void SendToSocket(int sockID, char *buffer, int packetSize,char *toName);
+extern int ReadBatchFromSocket(int sockID, char **buffers, int packetSize,
+				int maxPackets);
+extern void SendBatchToSocket(int sockID, char **buffers, int packetSize,
+				char **toNames, int numPackets);
+
+#define MaxSocketBatch 32	// most packets moved by one batch call
+
+// Shared memory, for simulating the network between Nachos on one host
+extern char *MapSharedFile(char *name, int size, bool create);
+extern void UnmapSharedFile(char *addr, int size);
+extern void MemoryBarrier();
 
 #endif // SYSDEP_H
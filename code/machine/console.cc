@@ -139,6 +139,7 @@ ConsoleOutput::ConsoleOutput(char *writeFile, CallBackObj *toCall)
 
     callWhenDone = toCall;
     putBusy = FALSE;
+    putCount = 0;
 }
 
 //----------------------------------------------------------------------
@@ -161,7 +162,7 @@ ConsoleOutput::~ConsoleOutput()
 void ConsoleOutput::CallBack()
 {
     putBusy = FALSE;
-    kernel->stats->numConsoleCharsWritten++;
+    kernel->stats->numConsoleCharsWritten += putCount;
     callWhenDone->CallBack();
 }
 
@@ -176,5 +177,33 @@ void ConsoleOutput::PutChar(char ch)
     ASSERT(putBusy == FALSE);
     WriteFile(writeFileNo, &ch, sizeof(char));
     putBusy = TRUE;
+    putCount = 1;
     kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
 }
+
+//----------------------------------------------------------------------
+// ConsoleOutput::PutString()
+// 	Write a run of characters to the simulated display as a single
+//	transfer, schedule one interrupt for when it is done, and return.
+//----------------------------------------------------------------------
+
+void ConsoleOutput::PutString(char *str, int len)
+{
+    ASSERT(putBusy == FALSE);
+    WriteFile(writeFileNo, str, len);
+    putBusy = TRUE;
+    putCount = len;
+    kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
+}
+
+//----------------------------------------------------------------------
+// ConsoleOutput::WriteNow()
+// 	Write characters straight to the display, with no interrupt.
+//	This is for output still buffered when Nachos halts, after the
+//	interrupt and statistics objects may be gone.
+//----------------------------------------------------------------------
+
+void ConsoleOutput::WriteNow(char *str, int len)
+{
+    WriteFile(writeFileNo, str, len);
+}
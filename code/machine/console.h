@@ -80,6 +80,12 @@ class ConsoleOutput : public CallBackObj {
     void PutChar(char ch);	// Write "ch" to the console display, 
 				// and return immediately.  "callWhenDone" 
 				// will called when the I/O completes. 
+    void PutString(char *str, int len);
+    				// Write "len" characters as one transfer,
+				// with one interrupt when it completes
+    void WriteNow(char *str, int len);
+    				// Write with no interrupt; only for when
+				// Nachos is halting
     void CallBack();		// Invoked when next character can be put
 				// out to the display.
 
@@ -89,6 +95,7 @@ class ConsoleOutput : public CallBackObj {
 					// the next char can be put 
     bool putBusy;    			// Is a PutChar operation in progress?
 					// If so, you can't do another one!
+    int putCount;			// characters in that operation
 };
 
 #endif // CONSOLE_H
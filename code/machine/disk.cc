@@ -151,6 +151,26 @@ void Disk::WriteRequest(int sectorNumber, char *data)
     kernel->interrupt->Schedule(this, ticks, DiskInt);
 }
 
+//----------------------------------------------------------------------
+// Disk::WriteNow
+// 	Write a single disk sector straight to the UNIX file, without
+//	simulating the delay or interrupting anyone when it is done.
+//	This is for flushing buffered sectors while Nachos is halting,
+//	after the interrupt and statistics objects may be gone, so it
+//	touches neither.
+//
+//	"sectorNumber" -- the disk sector to write
+//	"data" -- the bytes to be written
+//----------------------------------------------------------------------
+
+void Disk::WriteNow(int sectorNumber, char *data)
+{
+    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+
+    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
+    WriteFile(fileno, data, SectorSize);
+}
+
 //----------------------------------------------------------------------
 // Disk::CallBack()
 // 	Called by the machine simulation when the disk interrupt occurs.
@@ -67,6 +67,11 @@ class Disk : public CallBackObj {
     					// Only one request allowed at a time!
     void WriteRequest(int sectorNumber, char* data);
 
+    void WriteNow(int sectorNumber, char* data);
+    					// Write a sector with no completion
+					// interrupt; only for when Nachos
+					// is halting and can't wait for one
+
     void CallBack();			// Invoked when disk request 
 					// finishes. In turn calls, callWhenDone.
 
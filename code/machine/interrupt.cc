@@ -253,6 +253,9 @@ void Interrupt::Halt()
     cout << "This is halt\n";
     kernel->stats->Print();
 	*/
+    if (kernel->printStats) {
+	kernel->stats->Print();
+    }
     delete debug;
 
     delete kernel; // Never returns.
@@ -11,25 +11,104 @@
 #include "copyright.h"
 #include "network.h"
 #include "main.h"
+#include "shmring.h"
+
+static PacketBuffer *freeBuffers = NULL; // head of the free buffer chain
+static int numFreeBuffers = 0;           // # of buffers on the chain
+
+//-----------------------------------------------------------------------
+// PacketBuffer::Get
+// 	Return a packet buffer for the caller to hold, reusing a free one
+//	if the pool has any.  Called from interrupt handlers as well as
+//	threads, so the pool is only touched with interrupts off.
+//-----------------------------------------------------------------------
+
+PacketBuffer *
+PacketBuffer::Get()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    PacketBuffer *buf;
+
+    if (freeBuffers != NULL)
+    {
+        buf = freeBuffers;
+        freeBuffers = buf->next;
+        numFreeBuffers--;
+        kernel->stats->numPacketBuffersReused++;
+    }
+    else
+    {
+        buf = new PacketBuffer;
+        kernel->stats->numPacketBuffersAllocated++;
+    }
+    buf->inUse = TRUE;
+    (void)kernel->interrupt->SetLevel(oldLevel);
+    return buf;
+}
+
+//-----------------------------------------------------------------------
+// PacketBuffer::Release
+// 	The holder of the buffer is done with it; give it back to the
+//	pool.  Only once the pool is full is it freed.
+//-----------------------------------------------------------------------
+
+void PacketBuffer::Release()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    ASSERT(inUse); // not released twice
+    inUse = FALSE;
+    if (numFreeBuffers < PacketPoolSize)
+    {
+        next = freeBuffers;
+        freeBuffers = this;
+        numFreeBuffers++;
+    }
+    else
+    {
+        delete this;
+    }
+    (void)kernel->interrupt->SetLevel(oldLevel);
+}
 
 //-----------------------------------------------------------------------
 // NetworkInput::NetworkInput
 // 	Initialize the simulation for the network input
 //
 //   	"toCall" is the interrupt handler to call when packet arrives
+//	"depth" is how many arrived packets can be buffered at once
 //-----------------------------------------------------------------------
 
-NetworkInput::NetworkInput(CallBackObj *toCall)
+NetworkInput::NetworkInput(CallBackObj *toCall, int depth)
 {
+    ASSERT(depth > 0);
+
     // set up the stuff to emulate asynchronous interrupts
     callWhenAvail = toCall;
-    packetAvail = FALSE;
-    inHdr.length = 0;
+    for (int i = 0; i < NetworkBatchSize; i++)
+        spare[i] = PacketBuffer::Get();
+    ring = new PacketBuffer *[depth];
+    ringDepth = depth;
+    head = 0;
+    count = 0;
 
-    sock = OpenSocket();
-    sprintf(sockName, "SOCKET_%d", kernel->hostName);
-    AssignNameToSocket(sockName, sock); // Bind socket to a filename
-                                        // in the current directory.
+    sharedRings = NULL;
+    nextShared = 0;
+    if (kernel->netSharedMemory)
+    { // one ring from each machine, instead of a socket
+        ASSERT(kernel->hostName < MaxSharedRingHosts);
+        sharedRings = new SharedRing *[MaxSharedRingHosts];
+        for (int i = 0; i < MaxSharedRingHosts; i++)
+            sharedRings[i] = new SharedRing(kernel->hostName, i, TRUE);
+        sock = -1;
+    }
+    else
+    {
+        sock = OpenSocket();
+        sprintf(sockName, "SOCKET_%d", kernel->hostName);
+        AssignNameToSocket(sockName, sock); // Bind socket to a filename
+                                            // in the current directory.
+    }
 
     // start polling for incoming packets
     kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
@@ -43,62 +122,146 @@ NetworkInput::NetworkInput(CallBackObj *toCall)
 
 NetworkInput::~NetworkInput()
 {
-    CloseSocket(sock);
-    DeAssignNameToSocket(sockName);
+    if (sharedRings != NULL)
+    {
+        for (int i = 0; i < MaxSharedRingHosts; i++)
+            delete sharedRings[i];
+        delete[] sharedRings;
+    }
+    else
+    {
+        CloseSocket(sock);
+        DeAssignNameToSocket(sockName);
+    }
+    for (; count > 0; count--) // only the ring holds these
+    {
+        delete ring[head];
+        head = (head + 1) % ringDepth;
+    }
+    delete[] ring;
+    for (int i = 0; i < NetworkBatchSize; i++)
+        delete spare[i];
 }
 
 //-----------------------------------------------------------------------
 // NetworkInput::CallBack
-//	Simulator calls this when a packet may be available to
+//	Simulator calls this when packets may be available to
 //	be read in from the simulated network.
 //
-//      First check to make sure packet is available & there's space to
-//	pull it in.  Then invoke the "callBack" registered by whoever
-//	wants the packet.
+//	Pull in every packet waiting on the socket, so that a burst
+//	isn't drained at one packet per poll.  Packets are read from the
+//	host in batches, straight into spare buffers; each buffer that is
+//	filled is passed on and replaced.  A packet that arrives while
+//	the ring is full is dropped, as a real interface would, and its
+//	buffer reused; the network is unreliable anyway.  Invoke the
+//	"callBack" registered by whoever wants the packets once per
+//	packet kept.
 //-----------------------------------------------------------------------
 
 void NetworkInput::CallBack()
 {
+    char *wires[NetworkBatchSize];
+    int numRead;
+
     // schedule the next time to poll for a packet
     kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
 
-    if (inHdr.length != 0) // do nothing if packet is already buffered
-        return;
-    if (!PollSocket(sock)) // do nothing if no packet to be read
-        return;
+    do
+    {
+        for (int i = 0; i < NetworkBatchSize; i++)
+            wires[i] = spare[i]->wire;
+        numRead = ReadBatch(wires);
+
+        for (int i = 0; i < numRead; i++)
+        {
+            PacketHeader *hdr = spare[i]->Header();
+            ASSERT((hdr->to == kernel->hostName) && (hdr->length <= MaxPacketSize));
+
+            if (count == ringDepth)
+            {
+                DEBUG(dbgNet, "Receive ring full, dropped packet from " << hdr->from);
+                kernel->stats->numPacketsDropped++;
+                continue;
+            }
+            ring[(head + count) % ringDepth] = spare[i];
+            spare[i] = PacketBuffer::Get();
+            count++;
+            if (count > kernel->stats->maxRecvRingOccupancy)
+                kernel->stats->maxRecvRingOccupancy = count;
+
+            DEBUG(dbgNet, "Network received packet from " << hdr->from << ", length " << hdr->length);
+            kernel->stats->numPacketsRecvd++;
 
-    // otherwise, read packet in
-    char *buffer = new char[MaxWireSize];
-    ReadFromSocket(sock, buffer, MaxWireSize);
+            // tell post office that the packet has arrived
+            callWhenAvail->CallBack();
+        }
+    } while (numRead == NetworkBatchSize);
+}
+
+//-----------------------------------------------------------------------
+// NetworkInput::ReadBatch
+// 	Read up to NetworkBatchSize packets into "wires", without
+//	waiting, from the socket or else from the shared rings.  The
+//	rings are visited starting at a different one each time, so that
+//	one busy sender can't starve the others.
+//
+//	Returns the number of packets read.
+//-----------------------------------------------------------------------
 
-    // divide packet into header and data
-    inHdr = *(PacketHeader *)buffer;
-    ASSERT((inHdr.to == kernel->hostName) && (inHdr.length <= MaxPacketSize));
-    bcopy(buffer + sizeof(PacketHeader), inbox, inHdr.length);
-    delete[] buffer;
+int NetworkInput::ReadBatch(char **wires)
+{
+    int numRead = 0;
 
-    DEBUG(dbgNet, "Network received packet from " << inHdr.from << ", length " << inHdr.length);
-    kernel->stats->numPacketsRecvd++;
+    if (sharedRings == NULL)
+        return ReadBatchFromSocket(sock, wires, MaxWireSize, NetworkBatchSize);
 
-    // tell post office that the packet has arrived
-    callWhenAvail->CallBack();
+    for (int i = 0; i < MaxSharedRingHosts && numRead < NetworkBatchSize; i++)
+    {
+        SharedRing *shared = sharedRings[(nextShared + i) % MaxSharedRingHosts];
+        while (numRead < NetworkBatchSize && shared->Get(wires[numRead]))
+            numRead++;
+    }
+    nextShared = (nextShared + 1) % MaxSharedRingHosts;
+    return numRead;
+}
+
+//-----------------------------------------------------------------------
+// NetworkInput::ReceiveBuffer
+// 	Hand over the oldest packet, in the buffer it arrived in, if one
+//	is buffered; otherwise return NULL.
+//-----------------------------------------------------------------------
+
+PacketBuffer *
+NetworkInput::ReceiveBuffer()
+{
+    if (count == 0)
+        return NULL;
+
+    PacketBuffer *buf = ring[head];
+    head = (head + 1) % ringDepth;
+    count--;
+    return buf;
 }
 
 //-----------------------------------------------------------------------
 // NetworkInput::Receive
-// 	Read a packet, if one is buffered
+// 	Read the oldest packet, if one is buffered
 //-----------------------------------------------------------------------
 
 PacketHeader
 NetworkInput::Receive(char *data)
 {
-    PacketHeader hdr = inHdr;
+    PacketBuffer *buf = ReceiveBuffer();
+    PacketHeader hdr;
 
-    inHdr.length = 0;
-    if (hdr.length != 0)
+    if (buf == NULL)
     {
-        bcopy(inbox, data, hdr.length);
+        hdr.length = 0;
+        return hdr;
     }
+    hdr = *buf->Header();
+    bcopy(buf->Data(), data, hdr.length);
+    buf->Release();
     return hdr;
 }
 
@@ -122,6 +285,15 @@ NetworkOutput::NetworkOutput(double reliability, CallBackObj *toCall)
     // set up the stuff to emulate asynchronous interrupts
     callWhenDone = toCall;
     sendBusy = FALSE;
+    inCallBack = FALSE;
+    batchCount = 0;
+    sharedRings = NULL;
+    if (kernel->netSharedMemory)
+    {
+        sharedRings = new SharedRing *[MaxSharedRingHosts];
+        for (int i = 0; i < MaxSharedRingHosts; i++)
+            sharedRings[i] = NULL;
+    }
     sock = OpenSocket();
 }
 
@@ -132,19 +304,83 @@ NetworkOutput::NetworkOutput(double reliability, CallBackObj *toCall)
 
 NetworkOutput::~NetworkOutput()
 {
+    FlushBatch();
     CloseSocket(sock);
+    if (sharedRings != NULL)
+    {
+        for (int i = 0; i < MaxSharedRingHosts; i++)
+            delete sharedRings[i];
+        delete[] sharedRings;
+    }
 }
 
 //-----------------------------------------------------------------------
 // NetworkOutput::CallBack
 // 	Called by simulator when another packet can be sent.
+//
+//	If the caller doesn't send another packet right away, the link
+//	has gone idle, so hand whatever is batched up to the host now.
 //-----------------------------------------------------------------------
 
 void NetworkOutput::CallBack()
 {
     sendBusy = FALSE;
     kernel->stats->numPacketsSent++;
+    inCallBack = TRUE;
     callWhenDone->CallBack();
+    inCallBack = FALSE;
+    if (!sendBusy)
+        FlushBatch();
+}
+
+//-----------------------------------------------------------------------
+// NetworkOutput::FlushBatch
+// 	Hand the batched packets to the host socket, in one system call.
+//-----------------------------------------------------------------------
+
+void NetworkOutput::FlushBatch()
+{
+    char *wires[NetworkBatchSize];
+    char *names[NetworkBatchSize];
+
+    if (batchCount == 0)
+        return;
+    for (int i = 0; i < batchCount; i++)
+    {
+        wires[i] = batch[i];
+        names[i] = batchNames[i];
+    }
+    SendBatchToSocket(sock, wires, MaxWireSize, names, batchCount);
+    kernel->stats->numSendBatches++;
+    kernel->stats->numPacketsBatched += batchCount;
+    batchCount = 0;
+}
+
+//-----------------------------------------------------------------------
+// NetworkOutput::SendShared
+// 	Put a packet into the shared ring to another machine, attaching
+//	to the ring the first time.  Like SendToSocket, give the other
+//	machine 10 seconds to create its ring; if it never does, or its
+//	ring is full, the packet is dropped.
+//-----------------------------------------------------------------------
+
+void NetworkOutput::SendShared(NetworkAddress to, char *packet)
+{
+    ASSERT(to >= 0 && to < MaxSharedRingHosts);
+
+    for (int retryCount = 0; retryCount < 10; retryCount++)
+    {
+        if (sharedRings[to] != NULL && sharedRings[to]->IsMapped())
+            break;
+        delete sharedRings[to];
+        sharedRings[to] = new SharedRing(to, kernel->hostName, FALSE);
+        if (!sharedRings[to]->IsMapped())
+            Delay(1);
+    }
+    if (!sharedRings[to]->IsMapped() || !sharedRings[to]->Put(packet))
+    {
+        DEBUG(dbgNet, "No room in shared ring to " << to << ", dropped");
+    }
 }
 
 //-----------------------------------------------------------------------
@@ -155,18 +391,22 @@ void NetworkOutput::CallBack()
 //
 // 	Note we always pad out a packet to MaxWireSize before putting it into
 // 	the socket, because it's simpler at the receive end.
+//
+//	To save host system calls, packets sent back to back -- from the
+//	send interrupt of the one before -- are collected into a batch,
+//	which goes to the socket when it is full or the link goes idle.
+//	A packet sent on an idle link goes out right away, so it doesn't
+//	wait for a batch.  With shared memory rings, packets go straight
+//	into the ring.
 //-----------------------------------------------------------------------
 
 void NetworkOutput::Send(PacketHeader hdr, char *data)
 {
-    char toName[32];
-
-    sprintf(toName, "SOCKET_%d", (int)hdr.to);
-
     ASSERT((sendBusy == FALSE) && (hdr.length > 0) &&
            (hdr.length <= MaxPacketSize) && (hdr.from == kernel->hostName));
     DEBUG(dbgNet, "Sending to addr " << hdr.to << ", length " << hdr.length);
 
+    sendBusy = TRUE;
     kernel->interrupt->Schedule(this, NetworkTime, NetworkSendInt);
 
     if (RandomNumber() % 100 >= chanceToWork * 100)
@@ -175,10 +415,16 @@ void NetworkOutput::Send(PacketHeader hdr, char *data)
         return;
     }
 
-    // concatenate hdr and data into a single buffer, and send it out
-    char *buffer = new char[MaxWireSize];
+    // concatenate hdr and data into the next slot of the batch
+    char *buffer = batch[batchCount];
     *(PacketHeader *)buffer = hdr;
     bcopy(data, buffer + sizeof(PacketHeader), hdr.length);
-    SendToSocket(sock, buffer, MaxWireSize, toName);
-    delete[] buffer;
+    if (sharedRings != NULL)
+    { // no system call to save; put it straight in the ring
+        SendShared(hdr.to, buffer);
+        return;
+    }
+    sprintf(batchNames[batchCount], "SOCKET_%d", (int)hdr.to);
+    if (++batchCount == NetworkBatchSize || !inCallBack)
+        FlushBatch();
 }
@@ -19,6 +19,8 @@
 #include "utility.h"
 #include "callback.h"
 
+class SharedRing;
+
 // Network address -- uniquely identifies a machine.  This machine's ID
 //  is given on the command line.
 typedef int NetworkAddress;
@@ -43,6 +45,39 @@ public:
 #define MaxPacketSize (MaxWireSize - sizeof(struct PacketHeader))
 // data "payload" of the largest packet
 
+#define NetworkRingDepth 16 // default number of arrived packets the
+                            // input driver holds before dropping
+
+#define PacketPoolSize 64 // free packet buffers kept for reuse
+
+#define NetworkBatchSize 8 // packets moved to or from the host
+                           // socket in one system call
+
+// A buffer holding one packet exactly as it travels on the wire.  An
+// arriving packet is read from the socket straight into a buffer, and
+// the same buffer is passed up to whoever receives it, so the data is
+// not copied on the way.  A buffer has one holder at a time -- the
+// input ring, then a mailbox, then the receiving thread -- which gives
+// it back to a pool for the next packet once it is done with it.
+
+class PacketBuffer
+{
+public:
+    static PacketBuffer *Get(); // A buffer for the caller to hold
+
+    void Release();               // The holder is done; recycle the buffer
+
+    PacketHeader *Header() { return (PacketHeader *)wire; }
+    char *Data() { return wire + sizeof(PacketHeader); }
+    // Packet header and data inside the buffer
+
+    char wire[MaxWireSize]; // The packet, header first
+
+private:
+    bool inUse;         // Handed out by Get and not yet Released
+    PacketBuffer *next; // Chain of free buffers in the pool
+};
+
 // The following two classes defines a physical network device.  The network
 // is capable of delivering fixed sized packets, in order but unreliably,
 // to other machines connected to the network.
@@ -56,29 +91,43 @@ public:
 class NetworkInput : public CallBackObj
 {
 public:
-    NetworkInput(CallBackObj *toCall);
-    // Allocate and initialize network input driver
+    NetworkInput(CallBackObj *toCall, int depth = NetworkRingDepth);
+    // Allocate and initialize network input driver,
+    // able to buffer "depth" arrived packets
     ~NetworkInput(); // De-allocate the network input driver data
 
     PacketHeader Receive(char *data);
     // Poll the network for incoming messages.
     // If there is a packet waiting, copy the
-    // packet into "data" and return the header.
-    // If no packet is waiting, return a header
-    // with length 0.
+    // oldest one into "data" and return the
+    // header.  If no packet is waiting, return
+    // a header with length 0.
+    PacketBuffer *ReceiveBuffer();
+    // As above, but hand over the buffer the
+    // packet arrived in, or NULL; the caller
+    // must Release it.
 
-    void CallBack(); // A packet may have arrived.
+    void CallBack(); // Packets may have arrived; pull in all of
+                     // them that fit in the ring.
 
 private:
     int sock;          // UNIX socket number for incoming packets
     char sockName[32]; // File name corresponding to UNIX socket
+    SharedRing **sharedRings; // Rings from each machine, when the
+        //   network runs over shared memory; else NULL
+    int nextShared;           // Shared ring to read first next time
 
+    int ReadBatch(char **wires); // Read up to a batch of packets from
+        //   the socket or the shared rings
     CallBackObj *callWhenAvail; // Interrupt handler, signalling packet has
         // 	arrived.
-    bool packetAvail; // Packet has arrived, can be pulled off of
-        //   network
-    PacketHeader inHdr;        // Information about arrived packet
-    char inbox[MaxPacketSize]; // Data for arrived packet
+    PacketBuffer *spare[NetworkBatchSize]; // Empty buffers for the
+        //   next batch read from the socket
+    PacketBuffer **ring; // Packets pulled off the network, oldest
+        //   at ring[head]
+    int ringDepth;       // Number of slots in the ring
+    int head;            // Slot of the oldest buffered packet
+    int count;           // Number of buffered packets
 };
 
 class NetworkOutput : public CallBackObj
@@ -103,10 +152,23 @@ public:
 
 private:
     int sock;                  // UNIX socket number for outgoing packets
+    SharedRing **sharedRings;  // Rings to each machine, attached when
+        //   first used, if the network runs over shared memory
     double chanceToWork;       // Likelihood packet will be dropped
     CallBackObj *callWhenDone; // Interrupt handler, signalling next packet
         //      can be sent.
     bool sendBusy; // Packet is being sent.
+    bool inCallBack; // callWhenDone is running, so another
+        //   packet may follow right behind this one
+
+    char batch[NetworkBatchSize][MaxWireSize]; // Packets sent, but not
+        //   yet handed to the host
+    char batchNames[NetworkBatchSize][32];     // Sockets they go to
+    int batchCount;                            // Packets in the batch
+
+    void FlushBatch(); // Hand the batch to the host socket
+    void SendShared(NetworkAddress to, char *packet);
+    // Put a packet in the ring to "to"
 };
 
 #endif // NETWORK_H
@@ -0,0 +1,94 @@
+// shmring.cc
+//	Routines for a single-producer, single-consumer packet ring in
+//	memory shared between two Nachos processes.
+//
+//	Each ring lives in a file in /tmp, named for the two machines,
+//	which both processes map into memory.  The memory barriers make
+//	sure a packet's bytes are in place before the producer publishes
+//	the new tail, and are read before the consumer frees the slot.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "shmring.h"
+#include "sysdep.h"
+
+// total bytes in a ring's mapping
+static const int SharedRingBytes =
+    sizeof(SharedRingHeader) + SharedRingSlots * MaxWireSize;
+
+//-----------------------------------------------------------------------
+// SharedRing::SharedRing
+// 	Map the ring that carries packets from one machine to another.
+//
+//	"to" -- the receiving machine, which creates the ring
+//	"from" -- the sending machine, which attaches to it
+//	"create" -- TRUE for the receiver; the ring starts out empty.
+//		The sender's attach fails, leaving the ring unmapped, if
+//		the receiver hasn't created it yet.
+//-----------------------------------------------------------------------
+
+SharedRing::SharedRing(NetworkAddress to, NetworkAddress from, bool create)
+{
+    sprintf(fileName, "/tmp/nachos_ring_%d_%d", (int)to, (int)from);
+    owner = create;
+    header = (SharedRingHeader *)MapSharedFile(fileName, SharedRingBytes, create);
+    slots = (header == NULL) ? NULL : (char *)(header + 1);
+}
+
+//-----------------------------------------------------------------------
+// SharedRing::~SharedRing
+// 	Unmap the ring.  The receiver also removes the file, so that a
+//	sender started later doesn't attach to a ring nobody reads.
+//-----------------------------------------------------------------------
+
+SharedRing::~SharedRing()
+{
+    if (header != NULL)
+        UnmapSharedFile((char *)header, SharedRingBytes);
+    if (owner)
+        (void)Unlink(fileName);
+}
+
+//-----------------------------------------------------------------------
+// SharedRing::Put
+// 	Copy a packet into the next free slot, and publish it to the
+//	consumer.  Only the sending machine calls this.
+//
+//	Returns FALSE, without copying, if the ring is full.
+//-----------------------------------------------------------------------
+
+bool SharedRing::Put(char *packet)
+{
+    unsigned tail = header->tail;
+
+    if (tail - header->head == SharedRingSlots)
+        return FALSE;
+    bcopy(packet, slots + (tail % SharedRingSlots) * MaxWireSize, MaxWireSize);
+    MemoryBarrier(); // packet is in place before the tail moves
+    header->tail = tail + 1;
+    return TRUE;
+}
+
+//-----------------------------------------------------------------------
+// SharedRing::Get
+// 	Copy the oldest packet out of the ring, and free its slot for the
+//	producer.  Only the receiving machine calls this.
+//
+//	Returns FALSE if the ring is empty.
+//-----------------------------------------------------------------------
+
+bool SharedRing::Get(char *packet)
+{
+    unsigned head = header->head;
+
+    if (head == header->tail)
+        return FALSE;
+    MemoryBarrier(); // see the tail before reading the packet
+    bcopy(slots + (head % SharedRingSlots) * MaxWireSize, packet, MaxWireSize);
+    MemoryBarrier(); // packet is read before the slot is freed
+    header->head = head + 1;
+    return TRUE;
+}
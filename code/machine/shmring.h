@@ -0,0 +1,68 @@
+// shmring.h
+//	Data structures for a packet ring in memory shared between two
+//	Nachos processes on the same host.
+//
+//	As an alternative to UNIX sockets, the network device can deliver
+//	packets through one ring per pair of machines.  Each ring has a
+//	single producer (the sending machine) and a single consumer (the
+//	receiving machine), so no locks are needed: the producer only
+//	advances the tail, the consumer only advances the head.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "network.h"
+
+#define SharedRingSlots 64  // packets a ring can hold
+#define MaxSharedRingHosts 16 // machine IDs that can use shared rings
+
+// The indices at the front of a ring.  Both are free-running counts;
+// the ring is empty when they are equal, and full when they differ by
+// SharedRingSlots.  They are kept in separate cache lines, so the two
+// processes don't fight over one line.
+
+class SharedRingHeader
+{
+public:
+    volatile unsigned head; // Packets taken out, by the consumer
+    char pad[60];
+    volatile unsigned tail; // Packets put in, by the producer
+    char pad2[60];
+};
+
+// The following class defines one end of a shared ring.  The receiving
+// machine creates the ring, and removes it when it is done; the
+// sending machine attaches to it.
+
+class SharedRing
+{
+public:
+    SharedRing(NetworkAddress to, NetworkAddress from, bool create);
+    // Map the ring carrying packets from
+    // "from" to "to", creating it if asked
+    ~SharedRing(); // Unmap the ring; remove it if we created it
+
+    bool IsMapped() { return header != NULL; }
+    // Could the ring be attached?
+
+    bool Put(char *packet);
+    // Copy a MaxWireSize packet in; FALSE if
+    // the ring is full
+    bool Get(char *packet);
+    // Copy the oldest packet out; FALSE if the
+    // ring is empty
+
+private:
+    char fileName[64];        // File holding the ring
+    bool owner;               // Did we create the ring?
+    SharedRingHeader *header; // Start of the mapping, or NULL
+    char *slots;              // Packet slots, after the header
+};
+
+#endif // SHMRING_H
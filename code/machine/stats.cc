@@ -19,9 +19,27 @@
 Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
-    numDiskReads = numDiskWrites = 0;
+    numDiskReads = numDiskWrites = numDiskCacheHits = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numPacketsDropped = maxRecvRingOccupancy = 0;
+    numSendBatches = numPacketsBatched = 0;
+    numPacketBuffersAllocated = numPacketBuffersReused = 0;
+    numRemoteDiskRequests = 0;
+    numRemoteSectorsRead = numRemoteSectorsWritten = 0;
+    numRemoteFileRequests = 0;
+    numRemoteFileCacheHits = numRemoteFileBlocksFetched = 0;
+    numSegmentsSent = numSegmentsRetransmitted = numTransportTimeouts = 0;
+    numTransportBytesSent = numTransportBytesDelivered = 0;
+    numRpcCalls = numRpcRetransmits = numRpcTimeouts = numRpcDuplicates = 0;
+    numStacksAllocated = numStacksReused = 0;
+    numContextSwitches = 0;
+    numUserStateSaves = numUserStateRestores = numUserStateSkips = 0;
+    numUserRegsCopied = 0;
+    for (int i = 0; i < NumSyscallCodes; i++) {
+	numSyscalls[i] = syscallTicks[i] = 0;
+	syscallNames[i] = NULL;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -36,10 +54,61 @@ Statistics::Print()
     cout << "Ticks: total " << totalTicks << ", idle " << idleTicks;
 		cout << ", system " << systemTicks << ", user " << userTicks <<"\n";
     cout << "Disk I/O: reads " << numDiskReads;
-		cout << ", writes " << numDiskWrites << "\n";
+		cout << ", writes " << numDiskWrites;
+		cout << ", cache hits " << numDiskCacheHits << "\n";
+    if (numRemoteDiskRequests > 0) {
+	cout << "Remote disk: requests " << numRemoteDiskRequests;
+		cout << ", sectors read " << numRemoteSectorsRead;
+		cout << ", written " << numRemoteSectorsWritten << "\n";
+    }
+    if (numRemoteFileRequests > 0) {
+	cout << "Remote files: requests " << numRemoteFileRequests;
+		cout << ", cached blocks read " << numRemoteFileCacheHits;
+		cout << ", fetched " << numRemoteFileBlocksFetched << "\n";
+    }
 		cout << "Console I/O: reads " << numConsoleCharsRead;
     cout << ", writes " << numConsoleCharsWritten << "\n";
     cout << "Paging: faults " << numPageFaults << "\n";
     cout << "Network I/O: packets received " << numPacketsRecvd;
-		cout << ", sent " << numPacketsSent << "\n";
+		cout << ", sent " << numPacketsSent;
+		cout << ", dropped " << numPacketsDropped;
+		cout << ", peak ring " << maxRecvRingOccupancy << "\n";
+    if (numSendBatches > 0) {
+	cout << "Network sends to host: batches " << numSendBatches;
+		cout << ", packets " << numPacketsBatched;
+		cout << ", per batch "
+		     << (double) numPacketsBatched / numSendBatches << "\n";
+    }
+    cout << "Transport: bytes sent " << numTransportBytesSent;
+		cout << ", delivered " << numTransportBytesDelivered;
+		cout << ", segments " << numSegmentsSent;
+		cout << ", retransmitted " << numSegmentsRetransmitted;
+		cout << ", timeouts " << numTransportTimeouts << "\n";
+    if (numRpcCalls > 0 || numRpcDuplicates > 0) {
+	cout << "RPC: calls " << numRpcCalls;
+		cout << ", retransmitted " << numRpcRetransmits;
+		cout << ", timed out " << numRpcTimeouts;
+		cout << ", duplicates received " << numRpcDuplicates << "\n";
+    }
+    cout << "Thread stacks: allocated " << numStacksAllocated;
+		cout << ", reused " << numStacksReused << "\n";
+    cout << "Context switches: " << numContextSwitches;
+		cout << ", user state saves " << numUserStateSaves;
+		cout << ", restores " << numUserStateRestores;
+		cout << ", skipped " << numUserStateSkips << "\n";
+    cout << "User register words copied: " << numUserRegsCopied;
+		cout << ", per switch " << (numContextSwitches > 0 ?
+		    (double) numUserRegsCopied / numContextSwitches : 0.0)
+		    << "\n";
+    for (int i = 0; i < NumSyscallCodes; i++) {
+	if (numSyscalls[i] > 0) {
+	    if (syscallNames[i] != NULL) {
+		cout << "Syscall " << syscallNames[i];
+	    } else {
+		cout << "Syscall " << i;
+	    }
+	    cout << ": calls " << numSyscalls[i];
+		cout << ", ticks " << syscallTicks[i] << "\n";
+	}
+    }
 }
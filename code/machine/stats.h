@@ -13,6 +13,9 @@
 
 #include "copyright.h"
 
+// System call codes (see userprog/syscall.h) are all below this bound
+const int NumSyscallCodes = 128;
+
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
 // many user instructions executed, etc.
@@ -30,11 +33,54 @@ class Statistics {
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
+    int numDiskCacheHits;	// number of sector reads the disk
+				// cache saved
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numSendBatches;		// host system calls that sent packets
+    int numPacketsBatched;	// packets they carried
+    int numPacketsDropped;	// number of packets dropped on arrival
+				// because the receive ring was full
+    int maxRecvRingOccupancy;	// most packets ever waiting in the
+				// receive ring
+    int numPacketBuffersAllocated; // number of packet buffers obtained
+				// from the host
+    int numPacketBuffersReused;	// number of packet buffers taken from
+				// the pool
+    int numRemoteDiskRequests;	// requests sent to a remote disk
+    int numRemoteSectorsRead;	// sectors read from a remote disk
+    int numRemoteSectorsWritten; // sectors written to a remote disk
+    int numRemoteFileRequests;	// requests sent to a remote file system
+    int numRemoteFileCacheHits;	// remote file blocks read from the cache
+    int numRemoteFileBlocksFetched; // remote file blocks read from the
+				// server
+    int numSegmentsSent;	// new data segments sent by reliable
+				// connections
+    int numSegmentsRetransmitted; // data segments sent again
+    int numTransportTimeouts;	// retransmit timers that ran out
+    int numTransportBytesSent;	// stream bytes handed to connections
+    int numTransportBytesDelivered; // stream bytes read from connections
+    int numRpcCalls;		// remote procedure calls made
+    int numRpcRetransmits;	// call requests sent again after a timeout
+    int numRpcTimeouts;		// calls that never got a reply
+    int numRpcDuplicates;	// repeated requests received by servers
+    int numStacksAllocated;	// number of thread stacks obtained from the host
+    int numStacksReused;	// number of thread stacks taken from the pool
+    int numContextSwitches;	// number of thread switches
+    int numUserStateSaves;	// number of user register sets saved
+    int numUserStateRestores;	// number of user register sets restored
+    int numUserStateSkips;	// number of switches back to a user thread
+				// whose registers were still in the machine
+    int numUserRegsCopied;	// register words moved by those saves
+				// and restores -- the cost of the switches
+    int numSyscalls[NumSyscallCodes];	// calls made, per system call code
+    int syscallTicks[NumSyscallCodes];	// ticks elapsed inside each system
+				// call, including time spent blocked
+    const char *syscallNames[NumSyscallCodes];	// filled in as the system
+				// calls are registered, for Print
 
     Statistics(); 		// initialize everything to zero
 
@@ -0,0 +1,285 @@
+// message.cc
+//	Routines to send and receive messages larger than a single Mail,
+//	by splitting them into fragments at the sender and reassembling
+//	them at the receiver.
+//
+//	Each fragment is an ordinary Mail whose data begins with a
+//	FragmentHeader.  The receiver keeps, for each mailbox, a list of
+//	messages that have started to arrive; a message is handed to the
+//	caller once all of its bytes are in.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "message.h"
+
+//----------------------------------------------------------------------
+// PartialMessage::PartialMessage
+//	Start reassembling a message, given the headers of its first
+//	fragment.
+//
+//	"pktH" -- source, destination machine ID's
+//	"mailH" -- source, destination mailbox ID's
+//	"fragH" -- message number and total length
+//----------------------------------------------------------------------
+
+PartialMessage::PartialMessage(PacketHeader pktH, MailHeader mailH,
+				FragmentHeader fragH)
+{
+    pktHdr = pktH;
+    mailHdr = mailH;
+    mailHdr.length = fragH.length;
+    msgId = fragH.msgId;
+    nextIndex = 0;
+    received = 0;
+    ASSERT(fragH.length <= MaxMessageSize);	// checked by Receive
+    buffer = new char[fragH.length > 0 ? fragH.length : 1];
+}
+
+//----------------------------------------------------------------------
+// PartialMessage::~PartialMessage
+//	Throw away the reassembly buffer.
+//----------------------------------------------------------------------
+
+PartialMessage::~PartialMessage()
+{
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// PartialMessage::Add
+//	Copy the next fragment of the message into place.
+//
+//	Fragments of a message are sent, and delivered, in order; if
+//	this is not the one we expect, some earlier fragment was lost and
+//	the message can never be completed.
+//
+//	Returns FALSE if the fragment doesn't fit the message.
+//
+//	"fragH" -- the fragment's header
+//	"fragData" -- the fragment's share of the message
+//	"fragLen" -- number of bytes in "fragData"
+//----------------------------------------------------------------------
+
+bool
+PartialMessage::Add(FragmentHeader fragH, char *fragData, int fragLen)
+{
+    if (fragH.index != nextIndex || fragH.length != mailHdr.length ||
+		received + fragLen > mailHdr.length) {
+	return FALSE;
+    }
+    bcopy(fragData, buffer + received, fragLen);
+    received += fragLen;
+    nextIndex++;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// MessageOutput::MessageOutput
+//	Initialize the sending side of the message layer.
+//
+//	"post" -- the post office that carries the fragments
+//----------------------------------------------------------------------
+
+MessageOutput::MessageOutput(PostOfficeOutput *post)
+{
+    postOffice = post;
+    nextMsgId = 0;
+}
+
+//----------------------------------------------------------------------
+// MessageOutput::~MessageOutput
+//	The post office belongs to the caller; nothing to do.
+//----------------------------------------------------------------------
+
+MessageOutput::~MessageOutput()
+{
+}
+
+//----------------------------------------------------------------------
+// MessageOutput::Send
+//	Split a message into fragments of at most MaxFragmentSize bytes,
+//	and mail them, in order, to the destination mailbox.  A message
+//	of no bytes still takes one fragment.
+//
+//	"pktHdr" -- source, destination machine ID's
+//	"mailHdr" -- source, destination mailbox ID's; "length" is the
+//		size of the whole message
+//	"data" -- the message
+//----------------------------------------------------------------------
+
+void
+MessageOutput::Send(PacketHeader pktHdr, MailHeader mailHdr, char *data)
+{
+    char fragment[MaxMailSize];
+    FragmentHeader fragH;
+    MailHeader fragMailHdr = mailHdr;
+    unsigned sent = 0;
+
+    fragH.msgId = nextMsgId++;
+    fragH.index = 0;
+    fragH.length = mailHdr.length;
+    ASSERT(fragH.length <= MaxMessageSize);
+    ASSERT(fragH.length / MaxFragmentSize < 0xffff);
+
+    DEBUG(dbgNet, "Sending message " << fragH.msgId << ", length "
+		<< fragH.length);
+    do {
+	unsigned size = mailHdr.length - sent;
+	if (size > MaxFragmentSize) {
+	    size = MaxFragmentSize;
+	}
+	bcopy((char *)&fragH, fragment, sizeof(FragmentHeader));
+	bcopy(data + sent, fragment + sizeof(FragmentHeader), size);
+	fragMailHdr.length = sizeof(FragmentHeader) + size;
+	postOffice->Send(pktHdr, fragMailHdr, fragment);
+
+	sent += size;
+	fragH.index++;
+    } while (sent < mailHdr.length);
+}
+
+//----------------------------------------------------------------------
+// MessageInput::MessageInput
+//	Initialize the receiving side of the message layer.
+//
+//	"post" -- the post office that delivers the fragments
+//	"nBoxes" -- the number of mail boxes in "post"
+//----------------------------------------------------------------------
+
+MessageInput::MessageInput(PostOfficeInput *post, int nBoxes)
+{
+    postOffice = post;
+    numBoxes = nBoxes;
+    partial = new List<PartialMessage *>[nBoxes];
+}
+
+//----------------------------------------------------------------------
+// MessageInput::~MessageInput
+//	Throw away any messages that were never completed.
+//----------------------------------------------------------------------
+
+MessageInput::~MessageInput()
+{
+    for (int i = 0; i < numBoxes; i++) {
+	while (!partial[i].IsEmpty()) {
+	    delete partial[i].RemoveFront();
+	}
+    }
+    delete [] partial;
+}
+
+//----------------------------------------------------------------------
+// MessageInput::Find
+//	Look up the message a fragment belongs to, among those being
+//	reassembled in a mailbox.  A message is named by the machine and
+//	mailbox that sent it, and its message number.
+//
+//	Returns NULL if the message's first fragment never arrived.
+//----------------------------------------------------------------------
+
+PartialMessage *
+MessageInput::Find(int box, PacketHeader pktHdr, MailHeader mailHdr,
+			FragmentHeader fragH)
+{
+    ListIterator<PartialMessage *> iter(&partial[box]);
+
+    for (; !iter.IsDone(); iter.Next()) {
+	PartialMessage *msg = iter.Item();
+	if (msg->pktHdr.from == pktHdr.from &&
+		msg->mailHdr.from == mailHdr.from && msg->msgId == fragH.msgId) {
+	    return msg;
+	}
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// MessageInput::Receive
+// 	Wait for a complete message to arrive in a mailbox, pulling
+//	fragments out of the post office and reassembling them until one
+//	message has all of its bytes.
+//
+//	Messages that lose a fragment are dropped; so is the oldest
+//	partly received message when too many are in progress.
+//
+//	Returns the number of bytes copied into "data"; the message is
+//	cut short if it is longer than "size".  mailHdr->length is the
+//	full length of the message.
+//
+//	"box" -- mailbox ID in which to look for message
+//	"pktHdr" -- address to put: source, destination machine ID's
+//	"mailHdr" -- address to put: source, destination mailbox ID's
+//	"data" -- address to put: message data
+//	"size" -- room in "data"
+//----------------------------------------------------------------------
+
+int
+MessageInput::Receive(int box, PacketHeader *pktHdr, MailHeader *mailHdr,
+			char *data, int size)
+{
+    ASSERT((box >= 0) && (box < numBoxes));
+
+    for (;;) {
+	// read each fragment in place, in the buffer it arrived in
+	PacketBuffer *buf = postOffice->ReceiveBuffer(box);
+	PacketHeader inPktHdr = *buf->Header();
+	MailHeader inMailHdr = *MailHeaderOf(buf);
+	char *fragment = MailDataOf(buf);
+	FragmentHeader fragH;
+
+	if (inMailHdr.length < sizeof(FragmentHeader)) {
+	    buf->Release();
+	    continue;			// not a fragment; ignore it
+	}
+	bcopy(fragment, (char *)&fragH, sizeof(FragmentHeader));
+	int fragLen = inMailHdr.length - sizeof(FragmentHeader);
+
+	PartialMessage *msg = Find(box, inPktHdr, inMailHdr, fragH);
+	if (fragH.index == 0 && (fragH.length > MaxMessageSize ||
+			fragH.length / MaxFragmentSize >= 0xffff)) {
+	    DEBUG(dbgNet, "Message too long, length " << fragH.length);
+	    buf->Release();
+	    continue;			// can't be a real message
+	}
+	if (fragH.index == 0) {		// a new message starts
+	    if (msg != NULL) {		// stale one with the same name
+		partial[box].Remove(msg);
+		delete msg;
+	    }
+	    if (partial[box].NumInList() == MaxPartialMessages) {
+		DEBUG(dbgNet, "Too many partial messages, dropping oldest");
+		delete partial[box].RemoveFront();
+	    }
+	    msg = new PartialMessage(inPktHdr, inMailHdr, fragH);
+	    partial[box].Append(msg);
+	} else if (msg == NULL) {
+	    buf->Release();
+	    continue;			// start of message was lost
+	}
+
+	bool added = msg->Add(fragH, fragment + sizeof(FragmentHeader), fragLen);
+	buf->Release();
+	if (!added) {
+	    DEBUG(dbgNet, "Lost a fragment of message " << fragH.msgId);
+	    partial[box].Remove(msg);
+	    delete msg;
+	    continue;
+	}
+	if (msg->received < msg->mailHdr.length) {
+	    continue;			// more fragments to come
+	}
+
+	// the message is complete; hand it over
+	partial[box].Remove(msg);
+	*pktHdr = msg->pktHdr;
+	*mailHdr = msg->mailHdr;
+	int copied = (int)msg->mailHdr.length < size ?
+				(int)msg->mailHdr.length : size;
+	bcopy(msg->buffer, data, copied);
+	delete msg;
+	return copied;
+    }
+}
@@ -0,0 +1,117 @@
+// message.h
+//	Data structures for sending messages of any size through the
+//	post office.
+//
+//	A single Mail holds only MaxMailSize bytes, so the message layer
+//	splits a larger message into numbered fragments, each sent as
+//	its own Mail, and glues them back together at the receiver.
+//
+//	The post office is unreliable, so a fragment can be lost; the
+//	message it belongs to then never completes and is thrown away.
+//	The network delivers packets in order, so a fragment that
+//	arrives out of sequence means an earlier one was lost.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef MESSAGE_H
+#define MESSAGE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "list.h"
+#include "post.h"
+
+// The following class defines the fragment header.  It is prepended
+// to each piece of a message, after the MailHeader.
+
+class FragmentHeader {
+  public:
+    unsigned short msgId;	// Message number, chosen by the sender
+    unsigned short index;	// Position of this fragment in the message
+    unsigned length;		// Bytes in the whole message
+};
+
+// Message bytes carried by each fragment
+
+#define MaxFragmentSize	(MaxMailSize - sizeof(FragmentHeader))
+
+// Longest message; the receiver allocates a buffer of the length in the
+// first fragment, so a bad one must not ask for more than this.  The
+// fragment index also limits a message to 0xffff fragments.
+
+#define MaxMessageSize	65536
+
+// Most partly received messages a mailbox keeps at once; when another
+// one starts, the oldest is discarded.
+
+#define MaxPartialMessages 8
+
+// A message that has started to arrive, but is not yet complete.
+
+class PartialMessage {
+  public:
+    PartialMessage(PacketHeader pktH, MailHeader mailH, FragmentHeader fragH);
+				// Allocate a buffer for the whole message
+    ~PartialMessage();		// De-allocate the buffer
+
+    bool Add(FragmentHeader fragH, char *fragData, int fragLen);
+				// Copy a fragment into place; return
+				// FALSE if it was not the next one
+
+    PacketHeader pktHdr;	// Sender's machine
+    MailHeader mailHdr;		// Sender's mailbox, total length
+    unsigned short msgId;	// Sender's message number
+    int nextIndex;		// Fragment expected next
+    unsigned received;		// Bytes copied in so far
+    char *buffer;		// The message being put together
+};
+
+// The following class sends messages of any size, by splitting them
+// into fragments.
+
+class MessageOutput {
+  public:
+    MessageOutput(PostOfficeOutput *post);
+				// Send messages through "post"
+    ~MessageOutput();
+
+    void Send(PacketHeader pktHdr, MailHeader mailHdr, char *data);
+    				// Send mailHdr.length bytes of "data" to
+				// a mailbox on a remote machine
+
+  private:
+    PostOfficeOutput *postOffice;	// Carries the fragments
+    unsigned short nextMsgId;	// Number for the next message sent
+};
+
+// The following class receives messages of any size, reassembling
+// them from their fragments.
+
+class MessageInput {
+  public:
+    MessageInput(PostOfficeInput *post, int nBoxes);
+				// Receive messages from the "nBoxes"
+				// mailboxes of "post"
+    ~MessageInput();		// Discard partly received messages
+
+    int Receive(int box, PacketHeader *pktHdr, MailHeader *mailHdr,
+		char *data, int size);
+    				// Wait for a complete message in "box";
+				// copy at most "size" bytes into "data",
+				// return the number copied
+
+  private:
+    PostOfficeInput *postOffice;	// Delivers the fragments
+    int numBoxes;		// Number of mail boxes
+    List<PartialMessage *> *partial;	// Messages being reassembled,
+				//   per mailbox, oldest first
+
+    PartialMessage *Find(int box, PacketHeader pktHdr,
+			MailHeader mailHdr, FragmentHeader fragH);
+				// The message a fragment belongs to,
+				// or NULL
+};
+
+#endif // MESSAGE_H
@@ -19,25 +19,6 @@
 #include "copyright.h"
 #include "post.h"
 
-//----------------------------------------------------------------------
-// Mail::Mail
-//      Initialize a single mail message, by concatenating the headers to
-//	the data.
-//
-//	"pktH" -- source, destination machine ID's
-//	"mailH" -- source, destination mailbox ID's
-//	"data" -- payload data
-//----------------------------------------------------------------------
-
-Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
-{
-    ASSERT(mailH.length <= MaxMailSize);
-
-    pktHdr = pktH;
-    mailHdr = mailH;
-    bcopy(msgData, data, mailHdr.length);
-}
-
 //----------------------------------------------------------------------
 // MailBox::MailBox
 //      Initialize a single mail box within the post office, so that it
@@ -49,7 +30,7 @@ Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
 
 MailBox::MailBox()
 { 
-    messages = new SynchList<Mail *>(); 
+    messages = new SynchList<PacketBuffer *>(); 
 }
 
 //----------------------------------------------------------------------
@@ -60,8 +41,15 @@ MailBox::MailBox()
 //	in the mailbox.
 //----------------------------------------------------------------------
 
+static void
+DeleteBuffer(PacketBuffer *buf)
+{
+    delete buf;
+}
+
 MailBox::~MailBox()
 { 
+    messages->Apply(DeleteBuffer);
     delete messages; 
 }
 
@@ -86,54 +74,41 @@ PrintHeader(PacketHeader pktHdr, MailHeader mailHdr)
 // 	Add a message to the mailbox.  If anyone is waiting for message
 //	arrival, wake them up!
 //
-//	We need to reconstruct the Mail message (by concatenating the headers
-//	to the data), to simplify queueing the message on the SynchList.
+//	The message is queued in the buffer it arrived in; nothing is
+//	copied.
 //
-//	"pktHdr" -- source, destination machine ID's
-//	"mailHdr" -- source, destination mailbox ID's
-//	"data" -- payload message data
+//	"buf" -- the arrived packet: headers and payload message data
 //----------------------------------------------------------------------
 
 void 
-MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data)
+MailBox::Put(PacketBuffer *buf)
 { 
-    Mail *mail = new Mail(pktHdr, mailHdr, data); 
-
-    messages->Append(mail);		// put on the end of the list of 
+    messages->Append(buf);		// put on the end of the list of 
 					// arrived messages, and wake up 
 					// any waiters
 }
 
 //----------------------------------------------------------------------
 // MailBox::Get
-// 	Get a message from a mailbox, parsing it into the packet header,
-//	mailbox header, and data. 
+// 	Get a message from a mailbox.  The headers and data are left in
+//	the buffer, where MailHeaderOf and MailDataOf find them.
 //
 //	The calling thread waits if there are no messages in the mailbox.
-//
-//	"pktHdr" -- address to put: source, destination machine ID's
-//	"mailHdr" -- address to put: source, destination mailbox ID's
-//	"data" -- address to put: payload message data
 //----------------------------------------------------------------------
 
-void 
-MailBox::Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data) 
+PacketBuffer *
+MailBox::Get() 
 { 
     DEBUG(dbgNet, "Waiting for mail in mailbox");
-    Mail *mail = messages->RemoveFront();	// remove message from list;
-						// will wait if list is empty
+    PacketBuffer *buf = messages->RemoveFront();
+					// remove message from list;
+					// will wait if list is empty
 
-    *pktHdr = mail->pktHdr;
-    *mailHdr = mail->mailHdr;
     if (debug->IsEnabled('n')) {
 	cout << "Got mail from mailbox: ";
-	PrintHeader(*pktHdr, *mailHdr);
+	PrintHeader(*buf->Header(), *MailHeaderOf(buf));
     }
-    bcopy(mail->data, data, mail->mailHdr.length);
-					// copy the message data into
-					// the caller's buffer
-    delete mail;			// we've copied out the stuff we
-					// need, we can now discard the message
+    return buf;
 }
 
 //----------------------------------------------------------------------
@@ -148,16 +123,18 @@ MailBox::Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data)
 //	by the interrupt handlers, because it requires a Lock.
 //
 //	"nBoxes" is the number of mail boxes in this Post Office
+//	"ringDepth" is how many arrived packets the network holds
+//	  before the postal worker gets to them
 //----------------------------------------------------------------------
 
-PostOfficeInput::PostOfficeInput(int nBoxes)
+PostOfficeInput::PostOfficeInput(int nBoxes, int ringDepth)
 {
     messageAvailable = new Semaphore("message available", 0);
 
     numBoxes = nBoxes;
     boxes = new MailBox[nBoxes];
 
-    network = new NetworkInput(this);
+    network = new NetworkInput(this, ringDepth);
 
     Thread *t = new Thread("postal worker", 1);
 
@@ -183,35 +160,34 @@ PostOfficeInput::~PostOfficeInput()
 // PostOffice::PostalDelivery
 // 	Wait for incoming messages, and put them in the right mailbox.
 //
-//      Incoming messages have had the PacketHeader stripped off,
-//	but the MailHeader is still tacked on the front of the data.
+//      Incoming messages arrive in a PacketBuffer holding the
+//	PacketHeader, then the MailHeader, then the data; the buffer
+//	itself goes into the mailbox.
 //----------------------------------------------------------------------
 
 void
 PostOfficeInput::PostalDelivery(void* data)
 {
     PostOfficeInput* _this = (PostOfficeInput*)data;
-    PacketHeader pktHdr;
-    MailHeader mailHdr;
-    char *buffer = new char[MaxPacketSize];
 
     for (;;) {
         // first, wait for a message
         _this->messageAvailable->P();	
-        pktHdr = _this->network->Receive(buffer);
+        PacketBuffer *buf = _this->network->ReceiveBuffer();
+	ASSERT(buf != NULL);
 
-        mailHdr = *(MailHeader *)buffer;
+        MailHeader *mailHdr = MailHeaderOf(buf);
         if (debug->IsEnabled('n')) {
 	    cout << "Putting mail into mailbox: ";
-	    PrintHeader(pktHdr, mailHdr);
+	    PrintHeader(*buf->Header(), *mailHdr);
         }
 
 	// check that arriving message is legal!
-	ASSERT(0 <= mailHdr.to && mailHdr.to < _this->numBoxes);
-	ASSERT(mailHdr.length <= MaxMailSize);
+	ASSERT(0 <= mailHdr->to && mailHdr->to < _this->numBoxes);
+	ASSERT(mailHdr->length <= MaxMailSize);
 
 	// put into mailbox
-        _this->boxes[mailHdr.to].Put(pktHdr, mailHdr, buffer + sizeof(MailHeader));
+        _this->boxes[mailHdr->to].Put(buf);
     }
 }
 
@@ -233,11 +209,36 @@ PostOfficeInput::PostalDelivery(void* data)
 void
 PostOfficeInput::Receive(int box, PacketHeader *pktHdr, 
 				MailHeader *mailHdr, char* data)
+{
+    PacketBuffer *buf = ReceiveBuffer(box);
+
+    *pktHdr = *buf->Header();
+    *mailHdr = *MailHeaderOf(buf);
+    bcopy(MailDataOf(buf), data, mailHdr->length);
+					// copy the message data into
+					// the caller's buffer
+    buf->Release();			// we've copied out the stuff we
+					// need, the buffer can be reused
+}
+
+//----------------------------------------------------------------------
+// PostOfficeInput::ReceiveBuffer
+// 	Retrieve a message from a specific box if one is available, 
+//	otherwise wait for a message to arrive in the box.  Return the
+//	buffer the message arrived in, so the caller can read it in
+//	place; the caller must Release it when done.
+//
+//	"box" -- mailbox ID in which to look for message
+//----------------------------------------------------------------------
+
+PacketBuffer *
+PostOfficeInput::ReceiveBuffer(int box)
 {
     ASSERT((box >= 0) && (box < numBoxes));
 
-    boxes[box].Get(pktHdr, mailHdr, data);
-    ASSERT(mailHdr->length <= MaxMailSize);
+    PacketBuffer *buf = boxes[box].Get();
+    ASSERT(MailHeaderOf(buf)->length <= MaxMailSize);
+    return buf;
 }
 
 //----------------------------------------------------------------------
@@ -261,26 +262,35 @@ PostOfficeInput::CallBack()
 //	  be delivered (e.g., reliability = 1 means the network never
 //	  drops any packets; reliability = 0 means the network never
 //	  delivers any packets)
+//	"queueDepth" is how many packets can wait while the network
+//	  is busy before senders have to wait
 //----------------------------------------------------------------------
 
-PostOfficeOutput::PostOfficeOutput(double reliability)
+PostOfficeOutput::PostOfficeOutput(double reliability, int queueDepth)
 {
-    messageSent = new Semaphore("message sent", 0);
-    sendLock = new Lock("message send lock");
+    ASSERT(queueDepth > 0);
+
+    queue = new OutgoingPacket[queueDepth];
+    this->queueDepth = queueDepth;
+    head = 0;
+    count = 0;
+    networkBusy = FALSE;
+    freeSlots = new Semaphore("send queue slots", queueDepth);
 
     network = new NetworkOutput(reliability, this);
 }
 
 //----------------------------------------------------------------------
 // PostOfficeOutput::~PostOfficeOutput
-// 	De-allocate the post office data structures.
+// 	De-allocate the post office data structures.  Any packets still
+//	in the queue are never sent.
 //----------------------------------------------------------------------
 
 PostOfficeOutput::~PostOfficeOutput()
 {
     delete network;
-    delete messageSent;
-    delete sendLock;
+    delete [] queue;
+    delete freeSlots;
 }
 
 //----------------------------------------------------------------------
@@ -288,6 +298,11 @@ PostOfficeOutput::~PostOfficeOutput()
 // 	Concatenate the MailHeader to the front of the data, and pass 
 //	the result to the Network for delivery to the destination machine.
 //
+//	If the network is idle the packet goes out at once; otherwise
+//	it is queued, and CallBack sends it when the network is free.
+//	Either way the caller continues without waiting for the packet
+//	to be put on the wire, unless the queue is full.
+//
 //	Note that the MailHeader + data looks just like normal payload
 //	data to the Network.
 //
@@ -299,9 +314,6 @@ PostOfficeOutput::~PostOfficeOutput()
 void
 PostOfficeOutput::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
 {
-    char* buffer = new char[MaxPacketSize];	// space to hold concatenated
-						// mailHdr + data
-
     if (debug->IsEnabled('n')) {
 	cout << "Post send: ";
 	PrintHeader(pktHdr, mailHdr);
@@ -313,25 +325,33 @@ PostOfficeOutput::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
     pktHdr.from = kernel->hostName;
     pktHdr.length = mailHdr.length + sizeof(MailHeader);
 
-    // concatenate MailHeader and data
-    bcopy((char *)&mailHdr, buffer, sizeof(MailHeader));
-    bcopy(data, buffer + sizeof(MailHeader), mailHdr.length);
+    freeSlots->P();			// wait for room in the queue
+
+    // the queue is shared with the interrupt handler
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
 
-    sendLock->Acquire();   		// only one message can be sent
-					// to the network at any one time
-    network->Send(pktHdr, buffer);
-    messageSent->P();			// wait for interrupt to tell us
-					// ok to send the next message
-    sendLock->Release();
+    // concatenate MailHeader and data into the next free slot
+    OutgoingPacket *slot = &queue[(head + count) % queueDepth];
+    slot->pktHdr = pktHdr;
+    bcopy((char *)&mailHdr, slot->data, sizeof(MailHeader));
+    bcopy(data, slot->data + sizeof(MailHeader), mailHdr.length);
+    count++;
 
-    delete [] buffer;			// we've sent the message, so
-					// we can delete our buffer
+    if (!networkBusy) {			// nothing in flight; send it now
+	networkBusy = TRUE;
+	network->Send(queue[head].pktHdr, queue[head].data);
+	head = (head + 1) % queueDepth;
+	count--;
+	freeSlots->V();
+    }
+    (void) kernel->interrupt->SetLevel(oldLevel);
 }
 
 //----------------------------------------------------------------------
 // PostOfficeOutput::CallBack
 // 	Interrupt handler, called when the next packet can be put onto the 
-//	network.
+//	network.  Send the oldest queued packet, if there is one, and
+//	free its slot for a waiting sender.
 //
 //	Called even if the previous packet was dropped.
 //----------------------------------------------------------------------
@@ -339,6 +359,12 @@ PostOfficeOutput::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
 void 
 PostOfficeOutput::CallBack()
 { 
-    messageSent->V();
+    if (count == 0) {
+	networkBusy = FALSE;
+	return;
+    }
+    network->Send(queue[head].pktHdr, queue[head].data);
+    head = (head + 1) % queueDepth;
+    count--;
+    freeSlots->V();
 }
-
@@ -56,22 +56,18 @@ class MailHeader {
 #define MaxMailSize 	(MaxPacketSize - sizeof(MailHeader))
 
 
-// The following class defines the format of an incoming/outgoing 
-// "Mail" message.  The message format is layered: 
+// The format of an incoming/outgoing "Mail" message is layered:
 //	network header (PacketHeader) 
 //	post office header (MailHeader) 
 //	data
+//
+// Incoming mail stays in the PacketBuffer it arrived in, all the way
+// to the thread that receives it; these find the parts of it.
 
-class Mail {
-  public:
-     Mail(PacketHeader pktH, MailHeader mailH, char *msgData);
-				// Initialize a mail message by
-				// concatenating the headers to the data
-
-     PacketHeader pktHdr;	// Header appended by Network
-     MailHeader mailHdr;	// Header appended by PostOffice
-     char data[MaxMailSize];	// Payload -- message data
-};
+inline MailHeader *MailHeaderOf(PacketBuffer *buf)
+	{ return (MailHeader *)buf->Data(); }
+inline char *MailDataOf(PacketBuffer *buf)
+	{ return buf->Data() + sizeof(MailHeader); }
 
 // The following class defines a single mailbox, or temporary storage
 // for messages.   Incoming messages are put by the PostOffice into the 
@@ -83,14 +79,37 @@ class MailBox {
     MailBox();			// Allocate and initialize mail box
     ~MailBox();			// De-allocate mail box
 
-    void Put(PacketHeader pktHdr, MailHeader mailHdr, char *data);
-   				// Atomically put a message into the mailbox
-    void Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data); 
+    void Put(PacketBuffer *buf);
+   				// Atomically put a message into the 
+				// mailbox; the mailbox takes over
+				// "buf" from the caller
+    PacketBuffer *Get();
    				// Atomically get a message out of the 
 				// mailbox (and wait if there is no message 
-				// to get!)
+				// to get!); the caller must Release it
   private:
-    SynchList<Mail *> *messages; // A mailbox is just a list of arrived messages
+    SynchList<PacketBuffer *> *messages;
+				// A mailbox is just a list of arrived
+				// messages
+};
+
+// Number of mailboxes the kernel's post office has; see remotedisk.h
+// and remotefs.h for the ones that are spoken for.
+
+#define NumMailBoxes 16
+
+// Default number of outgoing packets PostOfficeOutput will hold while
+// the network is busy; senders wait only when the queue is full.
+
+#define SendQueueDepth 16
+
+// An outgoing packet, with the MailHeader already prepended to the data,
+// waiting for the network to become free.
+
+class OutgoingPacket {
+  public:
+    PacketHeader pktHdr;	// Header for the Network
+    char data[MaxPacketSize];	// MailHeader + payload
 };
 
 // The following two classes defines a "Post Office", or a collection of 
@@ -104,13 +123,20 @@ class MailBox {
 
 class PostOfficeInput : public CallBackObj {
   public:
-    PostOfficeInput(int nBoxes); // Allocate and initialize Post Office
+    PostOfficeInput(int nBoxes, int ringDepth = NetworkRingDepth);
+				// Allocate and initialize Post Office;
+				// the network can buffer "ringDepth"
+				// packets before it drops any
     ~PostOfficeInput();		// De-allocate Post Office data
     
     void Receive(int box, PacketHeader *pktHdr, 
 		MailHeader *mailHdr, char *data);
     				// Retrieve a message from "box".  Wait if
 				// there is no message in the box.
+    PacketBuffer *ReceiveBuffer(int box);
+				// As above, but without copying: return
+				// the buffer the message arrived in, which
+				// the caller must Release
 
     static void PostalDelivery(void* data);
 				// Wait for incoming messages, 
@@ -129,23 +155,31 @@ class PostOfficeInput : public CallBackObj {
 
 class PostOfficeOutput : public CallBackObj {
   public:
-    PostOfficeOutput(double reliability);
+    PostOfficeOutput(double reliability, int queueDepth = SendQueueDepth);
 				// Allocate and initialize output
 				//   "reliability" is how many packets
 				//   get dropped by the underlying network
+				//   "queueDepth" is how many packets can
+				//   wait for the network
     ~PostOfficeOutput();	// De-allocate Post Office data
 
     void Send(PacketHeader pktHdr, MailHeader mailHdr, char *data);
-    				// Send a message to a mailbox on a remote 
-				// machine.  The fromBox in the MailHeader is 
-				// the return box for ack's.
+    				// Queue a message for a mailbox on a remote 
+				// machine and return; waits only if the
+				// send queue is full.  The fromBox in the 
+				// MailHeader is the return box for ack's.
 
     void CallBack();		// Called when outgoing packet has been 
 				// put on network; next packet can now be sent
     
   private:
     NetworkOutput *network;	// Physical network connection
-    Semaphore *messageSent;	// V'ed when next message can be sent to network
-    Lock *sendLock;		// Only one outgoing message at a time
+    OutgoingPacket *queue;	// Packets waiting for the network, oldest
+				//   at queue[head]
+    int queueDepth;		// Number of slots in the queue
+    int head;			// Slot of the oldest queued packet
+    int count;			// Number of queued packets
+    bool networkBusy;		// A packet is on its way out
+    Semaphore *freeSlots;	// Counts empty slots in the queue
 };
 #endif
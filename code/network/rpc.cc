@@ -0,0 +1,470 @@
+// rpc.cc
+//	Routines for calling procedures on another machine, and for
+//	serving such calls.
+//
+//	A client keeps a list of its calls that are waiting for replies.
+//	Its helper thread takes replies out of the client's mailbox and
+//	wakes up the caller each belongs to; the Alarm wakes up callers
+//	whose replies are late, and they send their requests again.
+//
+//	A server's helper thread takes requests out of its mailbox and
+//	queues them for a pool of worker threads, which run the
+//	procedures, so a slow call doesn't hold up the ones behind it.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "rpc.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// RpcClient::RpcClient
+//	Get ready to call procedures on a server, and start the thread
+//	that receives the replies.
+//
+//	"server", "serverBox" -- the machine and mailbox of the server
+//	"localBox" -- our mailbox; replies arrive here
+//----------------------------------------------------------------------
+
+RpcClient::RpcClient(NetworkAddress server, MailBoxAddress serverBox,
+		MailBoxAddress localBox)
+{
+    this->server = server;
+    this->serverBox = serverBox;
+    this->localBox = localBox;
+
+    // start at a random number (seeded by -rs), so a client that
+    // restarts is unlikely to get the server's remembered replies to
+    // its old calls
+    nextId = RandomNumber();
+    pending = new List<PendingCall *>;
+    kernel->alarm->AddClient(this);
+
+    Thread *t = kernel->NewThread("rpc client");
+    t->Fork(RpcClient::ReceiveWorker, this);
+}
+
+//----------------------------------------------------------------------
+// RpcClient::Call
+//	Run a procedure on the server, and wait for it to finish.  Other
+//	threads may make calls through the same client meanwhile.
+//
+//	If no reply comes within ReplyTimeout ticks of the request going
+//	out, send the request again; the server runs the procedure only
+//	once, however many copies of the request reach it.  Give up after
+//	RpcMaxAttempts tries.
+//
+//	Returns the number of bytes of results copied into "result", or
+//	RpcNoProcedure or RpcTimedOut.
+//
+//	"proc" -- the procedure's number
+//	"args", "argSize" -- its arguments, at most MaxRpcSize bytes
+//	"result", "resultSize" -- where to put its results, and the room
+//		there
+//----------------------------------------------------------------------
+
+int
+RpcClient::Call(int proc, char *args, int argSize, char *result,
+		int resultSize)
+{
+    PendingCall *call = new PendingCall;
+    char *request = new char[sizeof(RpcHeader) + argSize];
+    RpcHeader *hdr = (RpcHeader *)request;
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+    IntStatus oldLevel;
+    bool retry;
+    int attempts = 1;
+
+    ASSERT(proc >= 0 && proc < MaxRpcProcs);
+    ASSERT(argSize >= 0 && argSize <= MaxRpcSize);
+
+    call->result = result;
+    call->resultSize = resultSize;
+    call->status = RpcTimedOut;
+    call->done = new Semaphore("rpc reply", 0);
+
+    // the call must be pending before the request goes out, since
+    // sending can block, and the reply can beat us back; it has no
+    // deadline until the request is sent
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    call->id = nextId++;
+    call->state = CallSending;
+    pending->Append(call);
+    (void) kernel->interrupt->SetLevel(oldLevel);
+
+    hdr->id = call->id;
+    hdr->type = RpcRequest;
+    hdr->proc = proc;
+    hdr->status = 0;
+    bcopy(args, request + sizeof(RpcHeader), argSize);
+    pktHdr.to = server;
+    mailHdr.to = serverBox;
+    mailHdr.from = localBox;
+    mailHdr.length = sizeof(RpcHeader) + argSize;
+
+    kernel->stats->numRpcCalls++;
+    SendRequest(call, pktHdr, mailHdr, request);
+    do {
+	call->done->P();
+
+	oldLevel = kernel->interrupt->SetLevel(IntOff);
+	retry = (call->state == CallTimedOut && attempts < RpcMaxAttempts);
+	if (retry) {
+	    call->state = CallSending;
+	} else {
+	    pending->Remove(call);
+	}
+	(void) kernel->interrupt->SetLevel(oldLevel);
+
+	if (retry) {
+	    DEBUG(dbgNet, "Resending RPC " << call->id);
+	    attempts++;
+	    kernel->stats->numRpcRetransmits++;
+	    SendRequest(call, pktHdr, mailHdr, request);
+	}
+    } while (retry);
+
+    int status = call->status;
+    if (status == RpcTimedOut) {
+	kernel->stats->numRpcTimeouts++;
+    }
+    delete call->done;
+    delete call;
+    delete [] request;
+    return status;
+}
+
+//----------------------------------------------------------------------
+// RpcClient::SendRequest
+//	Send a call's request to the server, and only once it has gone
+//	out start the wait for the reply.  Sending blocks for as long as
+//	the request's fragments take to get through the post office, and
+//	that time must not count against the server.
+//
+//	If the reply arrived while we were still sending, leave the call
+//	answered.
+//----------------------------------------------------------------------
+
+void
+RpcClient::SendRequest(PendingCall *call, PacketHeader pktHdr,
+		       MailHeader mailHdr, char *request)
+{
+    kernel->messageOut->Send(pktHdr, mailHdr, request);
+
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    if (call->state == CallSending) {
+	call->state = CallWaiting;
+	call->deadline = kernel->stats->totalTicks +
+					ReplyTimeout(call->resultSize);
+    }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RpcClient::ReplyTimeout
+//	Return how many ticks to wait for a reply, once the request has
+//	been sent.  On top of RpcTimeout, allow for the packets still
+//	queued in the post office when Send returns, and for each call in
+//	flight, a round trip of fragments the size of this reply, since
+//	the other calls' traffic can go ahead of ours.  A packet goes out
+//	every NetworkTime ticks at best.
+//
+//	Called with interrupts off, as it looks at the pending calls.
+//
+//	"resultSize" -- the most bytes of results the reply can carry
+//----------------------------------------------------------------------
+
+int
+RpcClient::ReplyTimeout(int resultSize)
+{
+    int fragments = divRoundUp(sizeof(RpcHeader) + resultSize,
+			       MaxFragmentSize);
+
+    return RpcTimeout + (SendQueueDepth +
+			 2 * fragments * pending->NumInList()) * NetworkTime;
+}
+
+//----------------------------------------------------------------------
+// RpcClient::CallBack
+//	Called by the Alarm on every timer interrupt, with interrupts
+//	disabled.  Wake up each caller whose reply is overdue, so it can
+//	send its request again; we can't send from an interrupt handler.
+//----------------------------------------------------------------------
+
+void
+RpcClient::CallBack()
+{
+    ListIterator<PendingCall *> iter(pending);
+
+    for (; !iter.IsDone(); iter.Next()) {
+	PendingCall *call = iter.Item();
+	if (call->state == CallWaiting &&
+		kernel->stats->totalTicks >= call->deadline) {
+	    call->state = CallTimedOut;
+	    call->done->V();
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// RpcClient::ReceiveWorker
+//	Take replies out of our mailbox as they arrive, and give each to
+//	the call it answers.  Replies to calls that have already been
+//	answered, or have given up, are dropped, as is mail from anyone
+//	other than the server.
+//----------------------------------------------------------------------
+
+void
+RpcClient::ReceiveWorker(void *data)
+{
+    RpcClient *_this = (RpcClient *)data;
+    char *message = new char[MaxRpcMessage];
+    RpcHeader *hdr = (RpcHeader *)message;
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+
+    for (;;) {
+	int size = kernel->messageIn->Receive(_this->localBox, &pktHdr,
+				&mailHdr, message, MaxRpcMessage);
+
+	if (pktHdr.from != _this->server || mailHdr.from != _this->serverBox ||
+		size < (int)sizeof(RpcHeader) || (int)mailHdr.length != size ||
+		hdr->type != RpcReply ||
+		hdr->status > size - (int)sizeof(RpcHeader)) {
+	    continue;
+	}
+
+	IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+	ListIterator<PendingCall *> iter(_this->pending);
+	for (; !iter.IsDone(); iter.Next()) {
+	    PendingCall *call = iter.Item();
+	    if (call->id == hdr->id && call->state != CallReplied) {
+		call->status = hdr->status;
+		if (call->status > call->resultSize) {
+		    call->status = call->resultSize;
+		}
+		if (call->status > 0) {
+		    bcopy(message + sizeof(RpcHeader), call->result,
+				call->status);
+		}
+		call->state = CallReplied;
+		call->done->V();
+		break;
+	    }
+	}
+	(void) kernel->interrupt->SetLevel(oldLevel);
+    }
+}
+
+//----------------------------------------------------------------------
+// RpcServer::RpcServer
+//	Start serving calls, with no procedures yet.  One helper thread
+//	receives requests; "workers" more run procedures.
+//
+//	"box" -- the mailbox clients send requests to
+//	"workers" -- how many calls can run at once
+//----------------------------------------------------------------------
+
+RpcServer::RpcServer(MailBoxAddress box, int workers)
+{
+    ASSERT(workers > 0);
+
+    this->box = box;
+    for (int i = 0; i < MaxRpcProcs; i++) {
+	handlers[i] = NULL;
+	handlerArgs[i] = NULL;
+    }
+
+    lock = new Lock("rpc server lock");
+    calls = new ServerCall[RpcReplyCacheSize];
+    for (int i = 0; i < RpcReplyCacheSize; i++) {
+	calls[i].pktHdr.from = -1;	// matches no request
+	calls[i].done = TRUE;		// free for a new call
+    }
+    nextSlot = 0;
+    ready = new SynchList<ServerCall *>;
+
+    Thread *t = kernel->NewThread("rpc server");
+    t->Fork(RpcServer::ReceiveWorker, this);
+    for (int i = 0; i < workers; i++) {
+	t = kernel->NewThread("rpc worker");
+	t->Fork(RpcServer::Worker, this);
+    }
+}
+
+//----------------------------------------------------------------------
+// RpcServer::Register
+//	Offer a procedure to clients.
+//
+//	"proc" -- the number clients call it by
+//	"handler" -- the procedure
+//	"arg" -- passed to "handler" on each call
+//----------------------------------------------------------------------
+
+void
+RpcServer::Register(int proc, RpcHandler handler, void *arg)
+{
+    ASSERT(proc >= 0 && proc < MaxRpcProcs);
+    handlers[proc] = handler;
+    handlerArgs[proc] = arg;
+}
+
+//----------------------------------------------------------------------
+// RpcServer::ReceiveWorker
+//	Take requests out of our mailbox as they arrive.  A new call gets
+//	a slot and goes to the workers.  A repeated request for a call
+//	that has finished gets the same reply again; one for a call that
+//	is still running is dropped, as the reply is on its way.
+//
+//	Slots are reused in turn, skipping calls that are still running;
+//	if every slot is busy, the request is dropped and the client will
+//	send it again.
+//----------------------------------------------------------------------
+
+void
+RpcServer::ReceiveWorker(void *data)
+{
+    RpcServer *_this = (RpcServer *)data;
+    char *message = new char[MaxRpcMessage];
+    RpcHeader *hdr = (RpcHeader *)message;
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+
+    for (;;) {
+	int size = kernel->messageIn->Receive(_this->box, &pktHdr, &mailHdr,
+				message, MaxRpcMessage);
+	int resend = 0;
+
+	if (size < (int)sizeof(RpcHeader) || (int)mailHdr.length != size ||
+		hdr->type != RpcRequest) {
+	    continue;
+	}
+
+	_this->lock->Acquire();
+	ServerCall *call = _this->Find(pktHdr, mailHdr, hdr->id);
+	if (call != NULL) {
+	    kernel->stats->numRpcDuplicates++;
+	    if (call->done) {
+		resend = call->length;
+		bcopy(call->message, message, resend);
+	    }
+	} else {
+	    for (int i = 0; i < RpcReplyCacheSize; i++) {
+		int slot = (_this->nextSlot + i) % RpcReplyCacheSize;
+		if (_this->calls[slot].done) {
+		    call = &_this->calls[slot];
+		    _this->nextSlot = (slot + 1) % RpcReplyCacheSize;
+		    break;
+		}
+	    }
+	    if (call != NULL) {
+		call->pktHdr = pktHdr;
+		call->mailHdr = mailHdr;
+		call->id = hdr->id;
+		call->done = FALSE;
+		call->length = size;
+		bcopy(message, call->message, size);
+		_this->ready->Append(call);
+	    } else {
+		DEBUG(dbgNet, "RPC server busy, dropping call " << hdr->id);
+	    }
+	}
+	_this->lock->Release();
+
+	if (resend > 0) {
+	    _this->Reply(pktHdr, mailHdr, message, resend);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// RpcServer::Worker
+//	Run calls as they are queued, and send back their results.  The
+//	reply is kept in the call's slot, for repeated requests.
+//----------------------------------------------------------------------
+
+void
+RpcServer::Worker(void *data)
+{
+    RpcServer *_this = (RpcServer *)data;
+    char *reply = new char[MaxRpcMessage];
+    RpcHeader *replyHdr = (RpcHeader *)reply;
+
+    for (;;) {
+	ServerCall *call = _this->ready->RemoveFront();
+	RpcHeader *hdr = (RpcHeader *)call->message;
+	int proc = hdr->proc;
+
+	replyHdr->id = hdr->id;
+	replyHdr->type = RpcReply;
+	replyHdr->proc = proc;
+	replyHdr->status = RpcNoProcedure;
+	if (proc < MaxRpcProcs && _this->handlers[proc] != NULL) {
+	    replyHdr->status = (*_this->handlers[proc])(_this->handlerArgs[proc],
+				call->message + sizeof(RpcHeader),
+				call->length - sizeof(RpcHeader),
+				reply + sizeof(RpcHeader));
+	    ASSERT(replyHdr->status >= 0 && replyHdr->status <= MaxRpcSize);
+	}
+	int length = sizeof(RpcHeader) +
+			(replyHdr->status > 0 ? replyHdr->status : 0);
+
+	// once it is done, the slot can be reused, so send from our copy
+	_this->lock->Acquire();
+	PacketHeader pktHdr = call->pktHdr;
+	MailHeader mailHdr = call->mailHdr;
+	bcopy(reply, call->message, length);
+	call->length = length;
+	call->done = TRUE;
+	_this->lock->Release();
+
+	_this->Reply(pktHdr, mailHdr, reply, length);
+    }
+}
+
+//----------------------------------------------------------------------
+// RpcServer::Find
+//	Look up a recent call, named by the machine and mailbox that made
+//	it and its number.  The lock must be held.
+//
+//	Returns NULL if we have no record of the call.
+//----------------------------------------------------------------------
+
+ServerCall *
+RpcServer::Find(PacketHeader pktHdr, MailHeader mailHdr, unsigned id)
+{
+    for (int i = 0; i < RpcReplyCacheSize; i++) {
+	ServerCall *call = &calls[i];
+	if (call->pktHdr.from == pktHdr.from &&
+		call->mailHdr.from == mailHdr.from && call->id == id) {
+	    return call;
+	}
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// RpcServer::Reply
+//	Send a reply back where a request came from.
+//
+//	"pktHdr", "mailHdr" -- the headers the request arrived with
+//	"message" -- the reply: RpcHeader, then results
+//	"length" -- bytes in "message"
+//----------------------------------------------------------------------
+
+void
+RpcServer::Reply(PacketHeader pktHdr, MailHeader mailHdr, char *message,
+		int length)
+{
+    PacketHeader outPktHdr;
+    MailHeader outMailHdr;
+
+    outPktHdr.to = pktHdr.from;
+    outMailHdr.to = mailHdr.from;
+    outMailHdr.from = box;
+    outMailHdr.length = length;
+    kernel->messageOut->Send(outPktHdr, outMailHdr, message);
+}
@@ -0,0 +1,181 @@
+// rpc.h
+//	Data structures for remote procedure calls between machines,
+//	carried by the message layer.
+//
+//	A client sends a request naming a procedure and waits for the
+//	reply.  Every call has its own number, so any number of threads
+//	can have calls outstanding through one client at once; a helper
+//	thread matches each reply to the thread waiting for it.
+//
+//	Messages can be lost, so a request that isn't answered within a
+//	timeout is sent again, with the same number, a few times before
+//	the call fails.  The server remembers its recent replies and
+//	sends them again for repeated requests, instead of running the
+//	procedure twice.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RPC_H
+#define RPC_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "callback.h"
+#include "list.h"
+#include "message.h"
+#include "synch.h"
+#include "synchlist.h"
+
+// Kinds of RPC message
+
+enum RpcType { RpcRequest, RpcReply };
+
+// The following class defines the RPC header.  It is prepended to
+// the arguments of a request, and to the results of a reply.
+
+class RpcHeader {
+  public:
+    unsigned id;		// Call number, chosen by the client
+    unsigned short type;	// RpcRequest or RpcReply
+    unsigned short proc;	// Procedure to run
+    int status;			// Reply: bytes of result, or RpcNoProcedure
+};
+
+#define MaxRpcSize 1024		// most bytes of arguments, or of results
+#define MaxRpcMessage (sizeof(RpcHeader) + MaxRpcSize)
+#define MaxRpcProcs 16		// procedures a server can offer
+
+#define RpcTimeout (40 * NetworkTime)
+				// least ticks to wait for a reply, counted
+				// from when the request has gone out,
+				// before sending it again; see
+				// RpcClient::ReplyTimeout
+#define RpcMaxAttempts 5	// times a request is sent before the call
+				// fails
+#define RpcReplyCacheSize 32	// recent calls a server remembers
+#define DefaultRpcWorkers 4	// server threads running procedures
+
+// Results of a call, besides the number of bytes returned
+
+#define RpcNoProcedure	-1	// the server has no such procedure
+#define RpcTimedOut	-2	// no reply, after RpcMaxAttempts requests
+
+// A procedure offered by a server.  It is passed the "arg" it was
+// registered with, and the arguments of the call; it puts at most
+// MaxRpcSize bytes of results in "result", and returns how many.
+
+typedef int (*RpcHandler)(void *arg, char *args, int argSize, char *result);
+
+// States of a call in progress
+
+enum CallState { CallSending, CallWaiting, CallTimedOut, CallReplied };
+
+// A call waiting for its reply.
+
+class PendingCall {
+  public:
+    unsigned id;		// Call number
+    CallState state;		// Sending, waiting, timed out, or answered
+    int deadline;		// Tick at which to send the request again
+    char *result;		// Where to put the results
+    int resultSize;		// Room in "result"
+    int status;			// Bytes of result, or an error
+    Semaphore *done;		// V'ed on a reply or a timeout
+};
+
+// The following class calls procedures on one server.  Its mailbox
+// must not be shared with other users of the message layer.  Like a
+// ReliableConnection, a client is never deleted, since its receiver
+// thread waits on the mailbox forever.
+
+class RpcClient : public CallBackObj {
+  public:
+    RpcClient(NetworkAddress server, MailBoxAddress serverBox,
+		MailBoxAddress localBox);
+				// Call procedures served from "serverBox"
+				// on "server"; replies come to "localBox"
+
+    int Call(int proc, char *args, int argSize, char *result,
+		int resultSize);
+				// Run procedure "proc" on the server, and
+				// wait for its results; return the number
+				// of bytes of results, RpcNoProcedure, or
+				// RpcTimedOut
+
+    void CallBack();		// Alarm tick; time out late calls
+
+  private:
+    ~RpcClient();		// Not defined; see above
+
+    NetworkAddress server;	// Machine running the procedures
+    MailBoxAddress serverBox;	// Its mailbox
+    MailBoxAddress localBox;	// Our mailbox
+    unsigned nextId;		// Number of the next call
+    List<PendingCall *> *pending;
+				// Calls waiting for replies; touched only
+				//   with interrupts off, as the Alarm
+				//   checks them
+
+    void SendRequest(PendingCall *call, PacketHeader pktHdr,
+		     MailHeader mailHdr, char *request);
+				// Send a request, then start its deadline
+    int ReplyTimeout(int resultSize);
+				// Ticks to wait for a reply of this size
+    static void ReceiveWorker(void *data);
+				// Hand replies to waiting callers
+};
+
+// A request that has arrived at a server, and the reply to it once the
+// procedure has run.  Kept afterwards so a repeated request gets the
+// same reply.
+
+class ServerCall {
+  public:
+    PacketHeader pktHdr;	// Client's machine
+    MailHeader mailHdr;		// Client's mailbox
+    unsigned id;		// Client's call number
+    bool done;			// Has the procedure run?
+    int length;			// Bytes in "message"
+    char message[MaxRpcMessage];
+				// The request, then the reply
+};
+
+// The following class runs procedures for clients.  Its mailbox must
+// not be shared with other users of the message layer.
+
+class RpcServer {
+  public:
+    RpcServer(MailBoxAddress box, int workers = DefaultRpcWorkers);
+				// Serve calls arriving in "box"; run up to
+				// "workers" procedures at once
+
+    void Register(int proc, RpcHandler handler, void *arg);
+				// Offer procedure number "proc"
+
+  private:
+    MailBoxAddress box;		// Where requests arrive
+    RpcHandler handlers[MaxRpcProcs];	// Procedures, by number
+    void *handlerArgs[MaxRpcProcs];	// What to pass each one
+
+    Lock *lock;			// Protects the calls below
+    ServerCall *calls;		// Recent calls, in RpcReplyCacheSize
+				//   slots, reused in turn
+    int nextSlot;		// Slot for the next new call
+    SynchList<ServerCall *> *ready;
+				// Calls waiting for a worker
+
+    static void ReceiveWorker(void *data);
+				// Take in requests, answer repeats
+    static void Worker(void *data);
+				// Run procedures and send the replies
+
+    ServerCall *Find(PacketHeader pktHdr, MailHeader mailHdr,
+		unsigned id);	// A recent call, or NULL
+    void Reply(PacketHeader pktHdr, MailHeader mailHdr, char *message,
+		int length);	// Send a reply to the client that made
+				// the request with these headers
+};
+
+#endif // RPC_H
@@ -0,0 +1,343 @@
+// transport.cc
+//	Routines for a sliding-window reliable connection over the
+//	post office.
+//
+//	Each end of a connection runs two helper threads: one takes
+//	segments and ACKs out of the connection's mailbox, the other
+//	resends unacknowledged segments when the retransmit timer, checked
+//	by the Alarm, runs out.  Threads calling Send and Receive wait on
+//	conditions that the receive helper signals.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "transport.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// ReliableConnection::ReliableConnection
+//	Set up this end of a connection, and start the helper threads.
+//
+//	"in", "out" -- the post office to carry segments
+//	"farHost", "farBox" -- the machine and mailbox at the other end
+//	"localBox" -- our mailbox; segments arrive here
+//	"window" -- how many segments can be sent before one is
+//		acknowledged
+//----------------------------------------------------------------------
+
+ReliableConnection::ReliableConnection(PostOfficeInput *in,
+		PostOfficeOutput *out, NetworkAddress farHost,
+		MailBoxAddress localBox, MailBoxAddress farBox, int window)
+{
+    ASSERT(window > 0);
+
+    postIn = in;
+    postOut = out;
+    this->farHost = farHost;
+    this->localBox = localBox;
+    this->farBox = farBox;
+
+    lock = new Lock("connection lock");
+    this->window = new Segment[window];
+    windowSize = window;
+    sendBase = nextSeq = 0;
+    windowOpen = new Condition("send window open");
+
+    recvNext = 0;
+    arrived = new List<PacketBuffer *>;
+    readOffset = 0;
+    dataArrived = new Condition("data arrived");
+
+    timerRunning = FALSE;
+    timerDeadline = 0;
+    timedOut = new Semaphore("retransmit timeout", 0);
+    kernel->alarm->AddClient(this);
+
+    Thread *t = kernel->NewThread("transport receiver");
+    t->Fork(ReliableConnection::ReceiveWorker, this);
+    t = kernel->NewThread("transport retransmitter");
+    t->Fork(ReliableConnection::RetransmitWorker, this);
+}
+
+//----------------------------------------------------------------------
+// ReliableConnection::Send
+//	Split "data" into segments and send them, in order.  Each segment
+//	stays in the send window until it is acknowledged; if the window
+//	is full, wait for an ACK to make room.
+//
+//	Returns once every byte has been sent at least once, not when
+//	it has been acknowledged.
+//
+//	"data" -- bytes to send
+//	"size" -- number of bytes
+//----------------------------------------------------------------------
+
+void
+ReliableConnection::Send(char *data, int size)
+{
+    lock->Acquire();
+    while (size > 0) {
+	while (nextSeq - sendBase >= (unsigned)windowSize) {
+	    windowOpen->Wait(lock);
+	}
+	Segment *seg = &window[nextSeq % windowSize];
+	int len = size < (int)MaxSegmentSize ? size : MaxSegmentSize;
+
+	seg->hdr.type = SegmentData;
+	seg->hdr.length = len;
+	seg->hdr.seq = nextSeq++;
+	bcopy(data, seg->data, len);
+	data += len;
+	size -= len;
+
+	if (!timerRunning) {
+	    StartTimer();
+	}
+	Transmit(seg);
+	kernel->stats->numSegmentsSent++;
+	kernel->stats->numTransportBytesSent += len;
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// ReliableConnection::Receive
+//	Wait until some of the stream has arrived, then copy as much of
+//	it as fits into "data".  Bytes come out in the order they were
+//	sent, with none missing or repeated.
+//
+//	Returns the number of bytes copied.
+//
+//	"data" -- address to put: stream bytes
+//	"size" -- room in "data"
+//----------------------------------------------------------------------
+
+int
+ReliableConnection::Receive(char *data, int size)
+{
+    int copied = 0;
+
+    lock->Acquire();
+    while (arrived->IsEmpty()) {
+	dataArrived->Wait(lock);
+    }
+    while (copied < size && !arrived->IsEmpty()) {
+	Segment *seg = (Segment *)MailDataOf(arrived->Front());
+	int len = seg->hdr.length - readOffset;
+
+	if (len > size - copied) {
+	    len = size - copied;
+	}
+	bcopy(seg->data + readOffset, data + copied, len);
+	copied += len;
+	readOffset += len;
+	if (readOffset == seg->hdr.length) {
+	    arrived->RemoveFront()->Release();
+	    readOffset = 0;
+	}
+    }
+    lock->Release();
+    kernel->stats->numTransportBytesDelivered += copied;
+    return copied;
+}
+
+//----------------------------------------------------------------------
+// ReliableConnection::ReceiveAll
+//	Keep receiving until "size" bytes have arrived; for protocols
+//	that send fixed-size records over the stream.
+//
+//	"data" -- address to put: stream bytes
+//	"size" -- number of bytes to wait for
+//----------------------------------------------------------------------
+
+void
+ReliableConnection::ReceiveAll(char *data, int size)
+{
+    int got = 0;
+
+    while (got < size) {
+	got += Receive(data + got, size - got);
+    }
+}
+
+//----------------------------------------------------------------------
+// ReliableConnection::CallBack
+//	Called by the Alarm on every timer interrupt, with interrupts
+//	disabled.  If the oldest unacknowledged segment has waited too
+//	long, wake up the retransmitter; we can't send from an interrupt
+//	handler, since sending may have to wait.
+//----------------------------------------------------------------------
+
+void
+ReliableConnection::CallBack()
+{
+    if (timerRunning && kernel->stats->totalTicks >= timerDeadline) {
+	timerRunning = FALSE;
+	kernel->stats->numTransportTimeouts++;
+	timedOut->V();
+    }
+}
+
+//----------------------------------------------------------------------
+// ReliableConnection::ReceiveWorker
+//	Take segments out of our mailbox as they arrive, and act on the
+//	acknowledgement and data in each.  Mail from anyone other than
+//	the far end of the connection is ignored.
+//
+//	Segments are read in the buffer they arrived in; one that is
+//	accepted stays there until Receive has read all of it.
+//----------------------------------------------------------------------
+
+void
+ReliableConnection::ReceiveWorker(void *data)
+{
+    ReliableConnection *_this = (ReliableConnection *)data;
+
+    for (;;) {
+	PacketBuffer *buf = _this->postIn->ReceiveBuffer(_this->localBox);
+	MailHeader *mailHdr = MailHeaderOf(buf);
+	Segment *seg = (Segment *)MailDataOf(buf);
+	bool kept = FALSE;
+
+	if (buf->Header()->from == _this->farHost &&
+		mailHdr->from == _this->farBox &&
+		mailHdr->length >= sizeof(SegmentHeader) &&
+		mailHdr->length - sizeof(SegmentHeader) == seg->hdr.length) {
+	    _this->lock->Acquire();
+	    _this->HandleAck(seg->hdr.ack);
+	    if (seg->hdr.type == SegmentData) {
+		kept = _this->HandleData(buf);
+	    }
+	    _this->lock->Release();
+	}
+	if (!kept) {
+	    buf->Release();
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// ReliableConnection::RetransmitWorker
+//	Each time the retransmit timer runs out, send every segment in
+//	the window again, oldest first.
+//----------------------------------------------------------------------
+
+void
+ReliableConnection::RetransmitWorker(void *data)
+{
+    ReliableConnection *_this = (ReliableConnection *)data;
+
+    for (;;) {
+	_this->timedOut->P();
+
+	_this->lock->Acquire();
+	if (_this->sendBase != _this->nextSeq) {
+	    DEBUG(dbgNet, "Retransmitting from segment " << _this->sendBase);
+	    _this->StartTimer();
+	    for (unsigned seq = _this->sendBase; seq != _this->nextSeq; seq++) {
+		_this->Transmit(&_this->window[seq % _this->windowSize]);
+		kernel->stats->numSegmentsRetransmitted++;
+	    }
+	}
+	_this->lock->Release();
+    }
+}
+
+//----------------------------------------------------------------------
+// ReliableConnection::Transmit
+//	Mail a segment to the far end, acknowledging everything we have
+//	received so far.  The lock must be held.
+//----------------------------------------------------------------------
+
+void
+ReliableConnection::Transmit(Segment *seg)
+{
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+
+    seg->hdr.ack = recvNext;
+    pktHdr.to = farHost;
+    mailHdr.to = farBox;
+    mailHdr.from = localBox;
+    mailHdr.length = sizeof(SegmentHeader) + seg->hdr.length;
+    postOut->Send(pktHdr, mailHdr, (char *)seg);
+}
+
+//----------------------------------------------------------------------
+// ReliableConnection::SendAck
+//	Send a segment with no data, just our acknowledgement.
+//----------------------------------------------------------------------
+
+void
+ReliableConnection::SendAck()
+{
+    Segment ack;
+
+    ack.hdr.type = SegmentAck;
+    ack.hdr.length = 0;
+    ack.hdr.seq = nextSeq;
+    Transmit(&ack);
+}
+
+//----------------------------------------------------------------------
+// ReliableConnection::HandleAck
+//	The far end has received every segment before "ack"; drop them
+//	from the send window, and wake up senders waiting for room.
+//	Old and duplicate ACKs change nothing.
+//----------------------------------------------------------------------
+
+void
+ReliableConnection::HandleAck(unsigned ack)
+{
+    if (ack - sendBase == 0 || ack - sendBase > nextSeq - sendBase) {
+	return;
+    }
+    sendBase = ack;
+    if (sendBase == nextSeq) {
+	timerRunning = FALSE;
+    } else {
+	StartTimer();
+    }
+    windowOpen->Broadcast(lock);
+}
+
+//----------------------------------------------------------------------
+// ReliableConnection::HandleData
+//	Accept a data segment if it is the next one in the stream, and
+//	acknowledge it.  Anything else is a duplicate, or follows a lost
+//	segment that will be resent; drop it, but acknowledge again so
+//	the sender learns where we are.
+//
+//	Returns TRUE if the segment was accepted; its buffer then belongs
+//	to the list of arrived segments.
+//----------------------------------------------------------------------
+
+bool
+ReliableConnection::HandleData(PacketBuffer *buf)
+{
+    Segment *seg = (Segment *)MailDataOf(buf);
+    bool accepted = (seg->hdr.seq == recvNext);
+
+    if (accepted) {
+	arrived->Append(buf);
+	recvNext++;
+	dataArrived->Broadcast(lock);
+    }
+    SendAck();
+    return accepted;
+}
+
+//----------------------------------------------------------------------
+// ReliableConnection::StartTimer
+//	Give the oldest unacknowledged segment RetransmitTimeout ticks
+//	to be acknowledged.
+//----------------------------------------------------------------------
+
+void
+ReliableConnection::StartTimer()
+{
+    timerDeadline = kernel->stats->totalTicks + RetransmitTimeout;
+    timerRunning = TRUE;
+}
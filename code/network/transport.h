@@ -0,0 +1,133 @@
+// transport.h
+//	Data structures for reliable, ordered delivery of a byte stream
+//	between mailboxes on two machines, over the unreliable post office.
+//
+//	The sender numbers each segment it sends, and keeps a copy until
+//	the receiver acknowledges it.  Up to a window's worth of segments
+//	can be outstanding at once, so the link is kept busy instead of
+//	waiting for each acknowledgement in turn.
+//
+//	The receiver accepts segments only in order, and acknowledges
+//	every segment it sees with the next sequence number it expects
+//	(a cumulative ACK).  If the oldest outstanding segment isn't
+//	acknowledged within a timeout, the sender sends the whole window
+//	again ("go back N").  The timeout is checked on each Alarm tick.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "callback.h"
+#include "list.h"
+#include "post.h"
+#include "synch.h"
+
+// Kinds of segment
+
+enum SegmentType { SegmentData, SegmentAck };
+
+// The following class defines the segment header.  It is prepended to
+// the data by the transport, after the MailHeader.  Every segment
+// carries an acknowledgement; a pure ACK carries no data.
+
+class SegmentHeader {
+  public:
+    unsigned short type;	// SegmentData or SegmentAck
+    unsigned short length;	// Bytes of data in this segment
+    unsigned seq;		// Sequence number of this data segment
+    unsigned ack;		// Next sequence number the sender expects
+};
+
+// Stream bytes carried by each segment
+
+#define MaxSegmentSize	(MaxMailSize - sizeof(SegmentHeader))
+
+#define DefaultSendWindow 8	// segments outstanding before Send waits
+#define RetransmitTimeout (20 * NetworkTime)
+				// ticks to wait for an ACK before sending
+				// the window again
+
+// A segment, as sent; received segments are read in place, in the
+// PacketBuffer they arrived in.
+
+class Segment {
+  public:
+    SegmentHeader hdr;		// Sequence number, length
+    char data[MaxSegmentSize];	// Stream bytes
+};
+
+// The following class defines one end of a reliable connection.  The
+// two ends each name the machine and mailbox of the other; a mailbox
+// must not be shared with other users of the post office.
+//
+// A connection lasts as long as Nachos does.  Its helper threads wait
+// on its mailbox and retransmit timer forever and there is no way to
+// stop them, so the destructor is private and never called.
+
+class ReliableConnection : public CallBackObj {
+  public:
+    ReliableConnection(PostOfficeInput *in, PostOfficeOutput *out,
+		NetworkAddress farHost, MailBoxAddress localBox,
+		MailBoxAddress farBox, int window = DefaultSendWindow);
+				// Start this end of a connection
+
+    void Send(char *data, int size);
+				// Queue "size" bytes for reliable delivery;
+				// waits while the send window is full
+    int Receive(char *data, int size);
+				// Wait for data, copy at most "size"
+				// bytes of it, return the number copied
+    void ReceiveAll(char *data, int size);
+				// Wait for exactly "size" bytes
+
+    void CallBack();		// Alarm tick; check the retransmit timer
+
+  private:
+    ~ReliableConnection();	// Not defined; see above
+
+    PostOfficeInput *postIn;	// Delivers segments and ACKs
+    PostOfficeOutput *postOut;	// Carries segments and ACKs
+    NetworkAddress farHost;	// Machine at the other end
+    MailBoxAddress localBox;	// Our mailbox
+    MailBoxAddress farBox;	// Their mailbox
+
+    Lock *lock;			// Protects everything below
+    Segment *window;		// Sent but unacknowledged segments, by
+				//   sequence number modulo windowSize
+    int windowSize;		// Segments that can be outstanding
+    unsigned sendBase;		// Oldest unacknowledged sequence number
+    unsigned nextSeq;		// Sequence number of the next new segment
+    Condition *windowOpen;	// Signalled when ACKs free window slots
+
+    unsigned recvNext;		// Sequence number we expect next
+    List<PacketBuffer *> *arrived;
+				// In-order segments not yet read
+    int readOffset;		// Bytes already read from the first one
+    Condition *dataArrived;	// Signalled when a segment is accepted
+
+    bool timerRunning;		// Waiting for an ACK?
+    int timerDeadline;		// Tick at which to retransmit
+    Semaphore *timedOut;	// V'ed when the retransmit timer expires
+
+    static void ReceiveWorker(void *data);
+				// Handle arriving segments and ACKs
+    static void RetransmitWorker(void *data);
+				// Resend the window on each timeout
+
+    void Transmit(Segment *seg);
+				// Put a segment on the wire, with our ACK
+    void SendAck();		// Acknowledge what we have received
+    void HandleAck(unsigned ack);
+				// Slide the send window
+    bool HandleData(PacketBuffer *buf);
+				// Accept the next segment of the stream;
+				// TRUE if "buf" was kept
+    void StartTimer();		// (Re)start the retransmit timer
+};
+
+#endif // TRANSPORT_H
@@ -0,0 +1,155 @@
+/* bufio.c
+ *	Buffered I/O for user programs (see bufio.h).
+ *
+ *	A BFile keeps track of its own file offset and uses PRead and
+ *	PWrite, so it never has to seek.  Its buffer either holds data
+ *	read ahead of the program (pos..len not handed out yet) or data
+ *	the program wrote that hasn't gone to the file yet (0..pos).
+ *	Requests of a whole buffer or more skip the buffer entirely.
+ */
+
+#include "bufio.h"
+
+static BFile files[BFILE_LIMIT];
+static int initialized = 0;
+
+BFile *bfopen(char *name)
+{
+	int i;
+	if (!initialized)
+	{
+		for (i = 0; i < BFILE_LIMIT; ++i)
+			files[i].fd = -1;
+		initialized = 1;
+	}
+	for (i = 0; i < BFILE_LIMIT; ++i)
+	{
+		if (files[i].fd < 0)
+		{
+			files[i].fd = Open(name);
+			if (files[i].fd < 0)
+				return 0;
+			files[i].writing = 0;
+			files[i].offset = 0;
+			files[i].pos = files[i].len = 0;
+			return &files[i];
+		}
+	}
+	return 0;
+}
+
+int bfflush(BFile *f)
+{
+	int n, i;
+	if (f->writing && f->pos > 0)
+	{
+		n = PWrite(f->buf, f->pos, f->offset, f->fd);
+		if (n < 0)
+			n = 0;
+		f->offset += n;
+		for (i = n; i < f->pos; ++i)	/* keep what didn't go out */
+			f->buf[i - n] = f->buf[i];
+		f->pos -= n;
+		if (f->pos > 0)
+			return -1;
+	}
+	else
+	{
+		f->offset += f->pos;	/* drop what was read ahead */
+	}
+	f->writing = 0;
+	f->pos = f->len = 0;
+	return 0;
+}
+
+int bfread(char *buffer, int size, BFile *f)
+{
+	int done = 0, n;
+	if (size < 0 || (f->writing && bfflush(f) < 0))
+		return -1;
+	while (done < size)
+	{
+		if (f->pos == f->len)
+		{
+			f->offset += f->len;
+			f->pos = f->len = 0;
+			if (size - done >= BFILE_BUF_SIZE)
+			{
+				n = PRead(buffer + done, size - done, f->offset, f->fd);
+				if (n < 0)
+					return -1;
+				f->offset += n;
+				return done + n;
+			}
+			n = PRead(f->buf, BFILE_BUF_SIZE, f->offset, f->fd);
+			if (n < 0)
+				return -1;
+			if (n == 0)
+				break;
+			f->len = n;
+		}
+		for (; f->pos < f->len && done < size; ++f->pos, ++done)
+			buffer[done] = f->buf[f->pos];
+	}
+	return done;
+}
+
+int bfwrite(char *buffer, int size, BFile *f)
+{
+	int done = 0, n;
+	if (size < 0)
+		return -1;
+	if (!f->writing)
+	{
+		bfflush(f);
+		f->writing = 1;
+	}
+	while (done < size)
+	{
+		if (f->pos == BFILE_BUF_SIZE && bfflush(f) < 0)
+			return -1;
+		f->writing = 1;
+		if (f->pos == 0 && size - done >= BFILE_BUF_SIZE)
+		{
+			n = PWrite(buffer + done, size - done, f->offset, f->fd);
+			if (n < 0)
+				return -1;
+			f->offset += n;
+			return done + n;
+		}
+		for (; f->pos < BFILE_BUF_SIZE && done < size; ++f->pos, ++done)
+			f->buf[f->pos] = buffer[done];
+	}
+	return done;
+}
+
+int bfgetc(BFile *f)
+{
+	char c;
+	if (!f->writing && f->pos < f->len)
+		return (unsigned char)f->buf[f->pos++];
+	if (bfread(&c, 1, f) != 1)
+		return -1;
+	return (unsigned char)c;
+}
+
+int bfputc(int c, BFile *f)
+{
+	char ch = c;
+	if (f->writing && f->pos < BFILE_BUF_SIZE)
+	{
+		f->buf[f->pos++] = ch;
+		return c;
+	}
+	if (bfwrite(&ch, 1, f) != 1)
+		return -1;
+	return c;
+}
+
+int bfclose(BFile *f)
+{
+	int flushed = bfflush(f);
+	int closed = Close(f->fd);
+	f->fd = -1;
+	return (flushed == 0 && closed == 1) ? 1 : -1;
+}
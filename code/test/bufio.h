@@ -0,0 +1,50 @@
+/* bufio.h
+ *	A small buffered I/O library for user programs, in the style of
+ *	stdio: bfopen/bfread/bfwrite/bfflush/bfclose on top of the
+ *	Open/PRead/PWrite/Close system calls.
+ *
+ *	Each BFile keeps one sector-sized buffer, so a program that
+ *	reads or writes a byte at a time still makes one system call per
+ *	sector instead of one per byte.  There is no malloc in user
+ *	programs, so BFiles come from a fixed pool.
+ */
+
+#ifndef BUFIO_H
+#define BUFIO_H
+
+#include "syscall.h"
+
+#define BFILE_BUF_SIZE	128	/* one disk sector */
+#define BFILE_LIMIT	8	/* BFiles open at once */
+
+typedef struct {
+    OpenFileId fd;		/* -1 if this BFile is free */
+    int writing;		/* buffer holds data to write, not data read */
+    int offset;			/* file offset of buf[0] */
+    int pos;			/* next byte of buf to use */
+    int len;			/* bytes of buf holding read data */
+    char buf[BFILE_BUF_SIZE];
+} BFile;
+
+/* Open the Nachos file "name"; return 0 if it can't be opened */
+BFile *bfopen(char *name);
+
+/* Like Read and Write, but buffered.  Return the number of bytes
+ * transferred, or -1 on failure.
+ */
+int bfread(char *buffer, int size, BFile *f);
+int bfwrite(char *buffer, int size, BFile *f);
+
+/* One byte at a time; bfgetc returns -1 at the end of the file */
+int bfgetc(BFile *f);
+int bfputc(int c, BFile *f);
+
+/* Write out any buffered data; return 0, or -1 on failure, in which
+ * case whatever could not be written stays buffered
+ */
+int bfflush(BFile *f);
+
+/* Flush and close; return 1, or -1 on failure */
+int bfclose(BFile *f);
+
+#endif /* BUFIO_H */
@@ -0,0 +1,69 @@
+#include "syscall.h"
+#include "bufio.h"
+
+// Write a file a byte at a time and read it back the same way, either
+// through bufio (bufio_bench) or with a raw system call per byte
+// (bufio_raw, built from this file with RAW_IO defined).  Compare the
+// two with "nachos -S -e bufio_bench" and "nachos -S -e bufio_raw".
+
+#define FILE_SIZE 4096
+
+char expected(int i)
+{
+	return 'a' + i % 26;
+}
+
+#ifdef RAW_IO
+int main(void)
+{
+	OpenFileId fid;
+	char c;
+	int i;
+	if (Create("/bench_raw", FILE_SIZE) != 1)
+		MSG("Failed on creating file");
+	fid = Open("/bench_raw");
+	if (fid < 0)
+		MSG("Failed on opening file");
+	for (i = 0; i < FILE_SIZE; ++i)
+	{
+		c = expected(i);
+		if (Write(&c, 1, fid) != 1)
+			MSG("Failed on writing file");
+	}
+	if (Seek(0, fid) != 0)
+		MSG("Failed on seeking");
+	for (i = 0; i < FILE_SIZE; ++i)
+		if (Read(&c, 1, fid) != 1 || c != expected(i))
+			MSG("Failed on reading file");
+	Close(fid);
+	MSG("Raw I/O done");
+	Halt();
+}
+#else
+int main(void)
+{
+	BFile *f;
+	int i;
+	if (Create("/bench_buffered", FILE_SIZE) != 1)
+		MSG("Failed on creating file");
+	f = bfopen("/bench_buffered");
+	if (f == 0)
+		MSG("Failed on opening file");
+	for (i = 0; i < FILE_SIZE; ++i)
+		if (bfputc(expected(i), f) < 0)
+			MSG("Failed on writing file");
+	if (bfclose(f) != 1)
+		MSG("Failed on closing file");
+	f = bfopen("/bench_buffered");
+	if (f == 0)
+		MSG("Failed on reopening file");
+	for (i = 0; i < FILE_SIZE; ++i)
+		if (bfgetc(f) != expected(i))
+			MSG("Failed on reading file");
+	if (bfgetc(f) != -1)
+		MSG("Failed: read past the end of file");
+	bfclose(f);
+	MSG("Buffered I/O done");
+	Halt();
+}
+#endif
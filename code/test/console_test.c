@@ -0,0 +1,24 @@
+#include "syscall.h"
+
+int main(void)
+{
+	char line[64];
+	int n;
+	// pieces of one line come out together, once the newline arrives
+	if (Write("Hello, ", 7, SysConsoleOutput) != 7)
+		MSG("Failed on writing console");
+	if (Write("console!\n", 9, SysConsoleOutput) != 9)
+		MSG("Failed on writing console");
+
+	// the prompt is shown before we wait for input; echo one line back
+	Write("Type a line: ", 13, SysConsoleOutput);
+	n = Read(line, 64, SysConsoleInput);
+	if (n < 0)
+		MSG("Failed on reading console");
+	Write("You typed: ", 11, SysConsoleOutput);
+	Write(line, n, SysConsoleOutput);
+
+	// a partial line is flushed when we exit
+	Write("Bye", 3, SysConsoleOutput);
+	return 0;
+}
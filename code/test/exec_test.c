@@ -0,0 +1,92 @@
+#include "syscall.h"
+
+// Driver: run batches of 1, 2, 4 and MAX_WORKERS copies of exec_worker
+// at once, join each batch, and print the ticks it took, to show how
+// throughput scales with the number of programs.
+// Copy both programs into the Nachos file system before running:
+//   nachos -cp exec_worker /exec_worker
+//   nachos -cp exec_test /exec_test
+//   nachos -e /exec_test
+#define MAX_WORKERS 8
+#define WORK "1000"
+#define WORK_SUM (1000 * 999 / 2)
+
+void Print(char *s)
+{
+	int len = 0;
+	while (s[len] != '\0')
+		++len;
+	Write(s, len, SysConsoleOutput);
+}
+
+void PrintNumber(int n)
+{
+	char digits[12];
+	int i = 11;
+	digits[i] = '\0';
+	do
+	{
+		digits[--i] = '0' + n % 10;
+		n /= 10;
+	} while (n > 0);
+	Print(&digits[i]);
+}
+
+// Start n workers, wait for them all, and return the ticks it took,
+// or -1 if a worker failed
+int RunBatch(int n)
+{
+	char *args[2];
+	SpaceId workers[MAX_WORKERS];
+	int i, start, ok = 1;
+	args[0] = "/exec_worker";
+	args[1] = WORK;
+	start = Ticks();
+	for (i = 0; i < n; ++i)
+	{
+		workers[i] = ExecV(2, args);
+		if (workers[i] < 0)
+		{
+			MSG("Failed on starting worker");
+			ok = 0;
+		}
+	}
+	for (i = 0; i < n; ++i)
+	{
+		if (workers[i] >= 0 && Join(workers[i]) != WORK_SUM)
+		{
+			MSG("Failed: wrong exit status from worker");
+			ok = 0;
+		}
+	}
+	if (n > 0 && workers[0] >= 0 && Join(workers[0]) != -1)
+	{
+		MSG("Failed: joined a worker twice");
+		ok = 0;
+	}
+	return ok ? Ticks() - start : -1;
+}
+
+int main(void)
+{
+	int n, ticks, passed = 1;
+	for (n = 1; n <= MAX_WORKERS; n *= 2)
+	{
+		ticks = RunBatch(n);
+		if (ticks < 0)
+		{
+			passed = 0;
+			continue;
+		}
+		Print("workers ");
+		PrintNumber(n);
+		Print(": ");
+		PrintNumber(ticks);
+		Print(" ticks, ");
+		PrintNumber(ticks / n);
+		Print(" per worker\n");
+	}
+	if (passed)
+		MSG("Passed! ^_^");
+	Halt();
+}
@@ -0,0 +1,15 @@
+#include "syscall.h"
+
+// Worker started by exec_test: sum 0..n-1, where n is argv[1]
+int main(int argc, char *argv[])
+{
+	int n = 0, sum = 0, i;
+	char *p;
+	if (argc != 2)
+		Exit(-1);
+	for (p = argv[1]; *p >= '0' && *p <= '9'; ++p)
+		n = n * 10 + (*p - '0');
+	for (i = 0; i < n; ++i)
+		sum += i;
+	Exit(sum);
+}
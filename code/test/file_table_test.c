@@ -0,0 +1,49 @@
+#include "syscall.h"
+
+#define NUM_OPEN 40
+
+OpenFileId fids[NUM_OPEN];
+
+int main(void)
+{
+	char buf[4];
+	OpenFileId dup;
+	int i;
+	if (Create("/table", 26) != 1)
+		MSG("Failed on creating file");
+
+	// more files open at once than the old system-wide limit of 20
+	for (i = 0; i < NUM_OPEN; ++i)
+	{
+		fids[i] = Open("/table");
+		if (fids[i] < 0)
+			MSG("Failed on opening file");
+	}
+	if (Write("abcdefghijklmnopqrstuvwxyz", 26, fids[0]) != 26)
+		MSG("Failed on writing file");
+
+	// a dup'ed id shares the seek position, a second Open does not
+	dup = Dup(fids[1]);
+	if (dup < 0)
+		MSG("Failed on dup");
+	if (Read(buf, 2, fids[1]) != 2 || buf[0] != 'a')
+		MSG("Failed on reading file");
+	if (Read(buf, 2, dup) != 2 || buf[0] != 'c')
+		MSG("Failed: dup does not share the seek position");
+	if (Close(fids[1]) != 1)
+		MSG("Failed on closing file");
+	if (Read(buf, 2, dup) != 2 || buf[0] != 'e')
+		MSG("Failed: dup closed with the original");
+	if (Read(buf, 2, fids[2]) != 2 || buf[0] != 'a')
+		MSG("Failed: separate opens share the seek position");
+
+	// closed ids are reused
+	if (Open("/table") != fids[1])
+		MSG("Failed: closed id was not reused");
+	if (Close(dup) != 1 || Close(dup) != -1)
+		MSG("Failed on closing dup");
+	if (Read(buf, 1, SysConsoleOutput + NUM_OPEN + 10) != -1)
+		MSG("Failed: read from an id that is not open");
+	MSG("Passed! ^_^");
+	Halt();
+}
@@ -0,0 +1,90 @@
+#include "syscall.h"
+
+#define RING_SIZE 16
+#define FILE_SIZE 256
+#define CHUNK 32
+#define NUM_CHUNKS (FILE_SIZE / CHUNK)
+
+IoSqe sq[RING_SIZE];
+IoCqe cq[RING_SIZE];
+IoRing ring;
+char data[FILE_SIZE];
+char got[FILE_SIZE];
+
+void queue(int op, OpenFileId fd, char *buf, int len, int position, int userData)
+{
+	IoSqe *sqe = &sq[ring.sqTail % RING_SIZE];
+	sqe->op = op;
+	sqe->fd = fd;
+	sqe->buf = buf;
+	sqe->len = len;
+	sqe->position = position;
+	sqe->userData = userData;
+	ring.sqTail++;
+}
+
+// submit what is queued, and return the result of the request tagged
+// "userData", consuming all completions
+int submit(int count, int userData)
+{
+	int result = -1;
+	if (IoSubmit(&ring) != count)
+		MSG("Failed on submitting the ring");
+	while (ring.cqHead != ring.cqTail)
+	{
+		IoCqe *cqe = &cq[ring.cqHead % RING_SIZE];
+		if (cqe->userData == userData)
+			result = cqe->result;
+		ring.cqHead++;
+	}
+	return result;
+}
+
+int main(void)
+{
+	OpenFileId fid;
+	int i, n;
+	ring.size = RING_SIZE;
+	ring.sq = sq;
+	ring.cq = cq;
+	for (i = 0; i < FILE_SIZE; ++i)
+		data[i] = 'a' + i % 26;
+
+	if (Create("/ring", FILE_SIZE) != 1)
+		MSG("Failed on creating file");
+	queue(IO_OP_OPEN, 0, "/ring", 0, -1, 100);
+	fid = submit(1, 100);
+	if (fid < 0)
+		MSG("Failed on opening file through the ring");
+
+	// one batch of writes, one chunk each
+	for (i = 0; i < NUM_CHUNKS; ++i)
+		queue(IO_OP_WRITE, fid, data + i * CHUNK, CHUNK, i * CHUNK, i);
+	if (IoSubmit(&ring) != NUM_CHUNKS)
+		MSG("Failed on submitting writes");
+	for (n = 0; ring.cqHead != ring.cqTail; ++n, ring.cqHead++)
+		if (cq[ring.cqHead % RING_SIZE].result != CHUNK)
+			MSG("Failed on a ring write");
+	if (n != NUM_CHUNKS)
+		MSG("Failed: missing write completions");
+
+	// one batch of reads, queued back to front; the kernel may reorder them
+	for (i = NUM_CHUNKS - 1; i >= 0; --i)
+		queue(IO_OP_READ, fid, got + i * CHUNK, CHUNK, i * CHUNK, i);
+	if (IoSubmit(&ring) != NUM_CHUNKS)
+		MSG("Failed on submitting reads");
+	for (n = 0; ring.cqHead != ring.cqTail; ++n, ring.cqHead++)
+		if (cq[ring.cqHead % RING_SIZE].result != CHUNK)
+			MSG("Failed on a ring read");
+	if (n != NUM_CHUNKS)
+		MSG("Failed: missing read completions");
+	for (i = 0; i < FILE_SIZE; ++i)
+		if (got[i] != data[i])
+			MSG("Failed: wrong data read through the ring");
+
+	queue(IO_OP_CLOSE, fid, 0, 0, -1, 200);
+	if (submit(1, 200) != 1)
+		MSG("Failed on closing file through the ring");
+	MSG("Passed! ^_^");
+	Halt();
+}
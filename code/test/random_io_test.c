@@ -0,0 +1,119 @@
+#include "syscall.h"
+
+#define FILE_SIZE 1000
+#define RECORD_SIZE 10
+#define NUM_RECORDS (FILE_SIZE / RECORD_SIZE)
+
+char record[RECORD_SIZE];
+
+void fill(int n)
+{
+	int i;
+	for (i = 0; i < RECORD_SIZE; ++i)
+		record[i] = 'a' + (n + i) % 26;
+}
+
+int check(int n)
+{
+	int i;
+	for (i = 0; i < RECORD_SIZE; ++i)
+		if (record[i] != 'a' + (n + i) % 26)
+			return 0;
+	return 1;
+}
+
+int main(void)
+{
+	OpenFileId fid;
+	int i, n;
+	if (Create("/records", FILE_SIZE) != 1)
+		MSG("Failed on creating file");
+	fid = Open("/records");
+	if (fid < 0)
+		MSG("Failed on opening file");
+
+	// write the records back to front, so every access is positional
+	for (i = NUM_RECORDS - 1; i >= 0; --i)
+	{
+		fill(i);
+		if (PWrite(record, RECORD_SIZE, i * RECORD_SIZE, fid) != RECORD_SIZE)
+			MSG("Failed on positional write");
+	}
+
+	// read them back in a scattered order
+	for (i = 0; i < NUM_RECORDS; ++i)
+	{
+		n = (i * 37) % NUM_RECORDS;
+		if (PRead(record, RECORD_SIZE, n * RECORD_SIZE, fid) != RECORD_SIZE || !check(n))
+			MSG("Failed on positional read");
+	}
+	if (PRead(record, RECORD_SIZE, FILE_SIZE, fid) != 0)
+		MSG("Failed: read past the end of file");
+
+	// the positional calls must not have moved the seek position
+	if (Read(record, RECORD_SIZE, fid) != RECORD_SIZE || !check(0))
+		MSG("Failed on sequential read");
+	if (Seek(42 * RECORD_SIZE, fid) != 42 * RECORD_SIZE)
+		MSG("Failed on seeking");
+	if (Read(record, RECORD_SIZE, fid) != RECORD_SIZE || !check(42))
+		MSG("Failed on reading after seek");
+	if (Seek(-1, fid) != -1)
+		MSG("Failed: seek to a negative position");
+
+	// gather a header and a record into one write, then scatter them back
+	{
+		char header[4] = {'H', 'D', 'R', ':'};
+		char got[4];
+		IoVec iov[2];
+		fill(7);
+		iov[0].base = header;
+		iov[0].len = 4;
+		iov[1].base = record;
+		iov[1].len = RECORD_SIZE;
+		if (Seek(0, fid) != 0 || WriteV(iov, 2, fid) != 4 + RECORD_SIZE)
+			MSG("Failed on vectored write");
+		for (i = 0; i < RECORD_SIZE; ++i)
+			record[i] = 0;
+		iov[0].base = got;
+		if (Seek(0, fid) != 0 || ReadV(iov, 2, fid) != 4 + RECORD_SIZE)
+			MSG("Failed on vectored read");
+		for (i = 0; i < 4; ++i)
+			if (got[i] != header[i])
+				MSG("Failed: wrong header from vectored read");
+		if (!check(7))
+			MSG("Failed: wrong record from vectored read");
+	}
+
+	// copy most of the file, from a misaligned offset, into a second file
+	{
+		OpenFileId copy;
+		if (Create("/records.copy", FILE_SIZE) != 1)
+			MSG("Failed on creating copy");
+		copy = Open("/records.copy");
+		if (copy < 0)
+			MSG("Failed on opening copy");
+		// the first two records were overwritten by the vectored write
+		if (Seek(2 * RECORD_SIZE, fid) != 2 * RECORD_SIZE)
+			MSG("Failed on seeking");
+		if (CopyFileRange(fid, copy, FILE_SIZE) != FILE_SIZE - 2 * RECORD_SIZE)
+			MSG("Failed on copying file");
+		for (i = 2; i < NUM_RECORDS; ++i)
+		{
+			if (PRead(record, RECORD_SIZE, (i - 2) * RECORD_SIZE, copy) != RECORD_SIZE || !check(i))
+				MSG("Failed: wrong data in copy");
+		}
+		if (Close(copy) != 1)
+			MSG("Failed on closing copy");
+	}
+
+	if (Fsync(fid) != 1)
+		MSG("Failed on syncing file");
+	if (Fsync(-1) != -1)
+		MSG("Failed: sync of a file that is not open");
+	Sync();
+
+	if (Close(fid) != 1)
+		MSG("Failed on closing file");
+	MSG("Passed! ^_^");
+	Halt();
+}
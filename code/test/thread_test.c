@@ -0,0 +1,46 @@
+#include "syscall.h"
+
+#define NUM_LOOPS 100
+
+int sum[2];
+
+void worker0(void)
+{
+	int i;
+	for (i = 0; i < NUM_LOOPS; ++i)
+	{
+		sum[0] += i;
+		ThreadYield();
+	}
+	ThreadExit(sum[0]);
+}
+
+void worker1(void)
+{
+	int i;
+	for (i = 0; i < NUM_LOOPS; ++i)
+	{
+		sum[1] += 2 * i;
+		ThreadYield();
+	}
+	// returning from the forked procedure exits with status 0
+}
+
+int main(void)
+{
+	ThreadId t0, t1;
+	t0 = ThreadFork(worker0);
+	if (t0 < 0)
+		MSG("Failed on forking thread 0");
+	t1 = ThreadFork(worker1);
+	if (t1 < 0)
+		MSG("Failed on forking thread 1");
+	if (ThreadJoin(t0) != NUM_LOOPS * (NUM_LOOPS - 1) / 2)
+		MSG("Failed: wrong exit code from thread 0");
+	if (ThreadJoin(t1) != 0)
+		MSG("Failed: wrong exit code from thread 1");
+	if (sum[1] != NUM_LOOPS * (NUM_LOOPS - 1))
+		MSG("Failed: thread 1 did not finish");
+	MSG("Passed! ^_^");
+	Halt();
+}
@@ -23,6 +23,37 @@
 Alarm::Alarm(bool doRandom)
 {
     timer = new Timer(doRandom, this);
+    clients = new List<CallBackObj *>;
+}
+
+//----------------------------------------------------------------------
+// Alarm::AddClient
+//	Arrange for "client" to be called back on every timer interrupt,
+//	with interrupts disabled.  Used by code that needs to notice
+//	when a timeout has passed, without a thread of its own polling.
+//----------------------------------------------------------------------
+
+void
+Alarm::AddClient(CallBackObj *client)
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    clients->Append(client);
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::RemoveClient
+//	Stop calling "client" back on timer interrupts.
+//----------------------------------------------------------------------
+
+void
+Alarm::RemoveClient(CallBackObj *client)
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    clients->Remove(client);
+    (void) kernel->interrupt->SetLevel(oldLevel);
 }
 
 //----------------------------------------------------------------------
@@ -39,8 +70,9 @@ Alarm::Alarm(bool doRandom)
 //	if the interrupted thread called Yield at the point it is 
 //	was interrupted.
 //
-//	For now, just provide time-slicing.  Only need to time slice 
-//      if we're currently running something (in other words, not idle).
+//	Provide time-slicing, and pass the tick on to any clients that
+//	asked for it.  Only need to time slice if we're currently
+//	running something (in other words, not idle).
 //----------------------------------------------------------------------
 
 void 
@@ -48,6 +80,11 @@ Alarm::CallBack()
 {
     Interrupt *interrupt = kernel->interrupt;
     MachineStatus status = interrupt->getStatus();
+    ListIterator<CallBackObj *> iter(clients);
+
+    for (; !iter.IsDone(); iter.Next()) {
+	iter.Item()->CallBack();
+    }
     
     if (status != IdleMode) {
 	interrupt->YieldOnReturn();
@@ -20,6 +20,7 @@
 #include "copyright.h"
 #include "utility.h"
 #include "callback.h"
+#include "list.h"
 #include "timer.h"
 
 // The following class defines a software alarm clock. 
@@ -27,15 +28,22 @@ class Alarm : public CallBackObj {
   public:
     Alarm(bool doRandomYield);	// Initialize the timer, and callback 
 				// to "toCall" every time slice.
-    ~Alarm() { delete timer; }
+    ~Alarm() { delete timer; delete clients; }
     
     void WaitUntil(int x);	// suspend execution until time > now + x
                                 // this method is not yet implemented
 	
 	void Disable() { timer->Disable(); } //2015.11.25
 
+    void AddClient(CallBackObj *client);
+				// also call "client" on every timer
+				// interrupt, e.g. to check timeouts
+    void RemoveClient(CallBackObj *client);
+				// stop calling "client"
+
   private:
     Timer *timer;		// the hardware timer device
+    List<CallBackObj *> *clients; // called on every timer interrupt
 
     void CallBack();		// called when the hardware
 				// timer generates an interrupt
@@ -16,7 +16,13 @@
 #include "string.h"
 #include "synchdisk.h"
 #include "post.h"
+#include "message.h"
+#include "transport.h"
+#include "rpc.h"
+#include "remotedisk.h"
+#include "remotefs.h"
 #include "synchconsole.h"
+#include "bitmap.h"
 
 //----------------------------------------------------------------------
 // Kernel::Kernel
@@ -28,18 +34,24 @@ Kernel::Kernel(int argc, char **argv)
 {
     randomSlice = FALSE; 
     debugUserProg = FALSE;
+    printStats = FALSE;
     consoleIn = NULL;          // default is stdin
     consoleOut = NULL;         // default is stdout
 #ifndef FILESYS_STUB
     formatFlag = FALSE;
 #endif
     reliability = 1;            // network reliability, default is 1.0
+    netRingDepth = NetworkRingDepth; // receive ring depth
+    netSharedMemory = FALSE;    // default is UNIX sockets
+    networkFlag = FALSE;        // no post office unless needed
+    remoteDiskHost = -1;        // disk is local
+    diskClientHost = -1;        // and not exported
+#ifndef FILESYS_STUB
+    remoteFileHost = -1;        // files are local
+#endif
     hostName = 0;               // machine id, also UNIX socket name
                                 // 0 is the default machine id
-								
-	// MP4 mod tag
-	execfileNum = 0; // dummy operation to keep valgrind happy
-								
+
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-rs") == 0) {
  	    	ASSERT(i + 1 < argc);
@@ -49,9 +61,11 @@ Kernel::Kernel(int argc, char **argv)
 	    	i++;
         } else if (strcmp(argv[i], "-s") == 0) {
             debugUserProg = TRUE;
+        } else if (strcmp(argv[i], "-S") == 0) {
+            printStats = TRUE;
 		} else if (strcmp(argv[i], "-e") == 0) {
-        	execfile[++execfileNum]= argv[++i];
-			cout << execfile[execfileNum] << "\n";
+			execfile.push_back(argv[++i]);
+			cout << execfile.back() << "\n";
 		} else if (strcmp(argv[i], "-ci") == 0) {
 	    	ASSERT(i + 1 < argc);
 	    	consoleIn = argv[i + 1];
@@ -68,18 +82,55 @@ Kernel::Kernel(int argc, char **argv)
             ASSERT(i + 1 < argc);   // next argument is float
             reliability = atof(argv[i + 1]);
             i++;
+        } else if (strcmp(argv[i], "-nr") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is int
+            netRingDepth = atoi(argv[i + 1]);
+            ASSERT(netRingDepth > 0);
+            i++;
+        } else if (strcmp(argv[i], "-shm") == 0) {
+            netSharedMemory = TRUE;
+        } else if (strcmp(argv[i], "-N") == 0) {
+            networkFlag = TRUE;     // main runs the network test
+        } else if (strcmp(argv[i], "-R") == 0) {
+            networkFlag = TRUE;     // main runs the RPC benchmark
+        } else if (strcmp(argv[i], "-dr") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is int
+            remoteDiskHost = atoi(argv[i + 1]);
+            networkFlag = TRUE;
+            i++;
+        } else if (strcmp(argv[i], "-ds") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is int
+            diskClientHost = atoi(argv[i + 1]);
+            networkFlag = TRUE;
+            i++;
+#ifndef FILESYS_STUB
+        } else if (strcmp(argv[i], "-fr") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is int
+            remoteFileHost = atoi(argv[i + 1]);
+            networkFlag = TRUE;
+            i++;
+        } else if (strcmp(argv[i], "-fs") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is int; may repeat
+            fileClientHosts.push_back(atoi(argv[i + 1]));
+            networkFlag = TRUE;
+            i++;
+#endif
         } else if (strcmp(argv[i], "-m") == 0) {
             ASSERT(i + 1 < argc);   // next argument is int
             hostName = atoi(argv[i + 1]);
             i++;
         } else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-rs randomSeed]\n";
-	   		cout << "Partial usage: nachos [-s]\n";
+	   		cout << "Partial usage: nachos [-s] [-S]\n";
             cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut]\n";
 #ifndef FILESYS_STUB
 	    	cout << "Partial usage: nachos [-nf]\n";
 #endif
-            cout << "Partial usage: nachos [-n #] [-m #]\n";
+            cout << "Partial usage: nachos [-n #] [-nr #] [-shm] [-m #]\n";
+            cout << "Partial usage: nachos [-dr #] [-ds #]\n";
+#ifndef FILESYS_STUB
+            cout << "Partial usage: nachos [-fr #] [-fs #]\n";
+#endif
 		}
     }
 }
@@ -99,7 +150,7 @@ Kernel::Initialize()
     // object to save its state. 
 
 	
-    currentThread = new Thread("main", threadNum++);		
+    currentThread = NewThread("main");
     currentThread->setStatus(RUNNING);
 
     stats = new Statistics();		// collect statistics
@@ -107,20 +158,45 @@ Kernel::Initialize()
     scheduler = new Scheduler();	// initialize the ready queue
     alarm = new Alarm(randomSlice);	// start up time slicing
     machine = new Machine(debugUserProg);
+    physPageMap = new Bitmap(NumPhysPages);
     synchConsoleIn = new SynchConsoleInput(consoleIn); // input from stdin
     synchConsoleOut = new SynchConsoleOutput(consoleOut); // output to stdout
+
+	// MP4 mod tag
+	// The network is polled forever, so Nachos never runs out of
+	// interrupts and halts by itself; only start the post office when
+	// something needs it.  It comes before the disk, which may be on
+	// another machine.
+    postOfficeIn = NULL;
+    postOfficeOut = NULL;
+    messageIn = NULL;
+    messageOut = NULL;
+    if (networkFlag) {
+	postOfficeIn = new PostOfficeInput(NumMailBoxes, netRingDepth);
+	postOfficeOut = new PostOfficeOutput(reliability);
+	messageIn = new MessageInput(postOfficeIn, NumMailBoxes);
+	messageOut = new MessageOutput(postOfficeOut);
+    }
+
     synchDisk = new SynchDisk();    //
 #ifdef FILESYS_STUB
     fileSystem = new FileSystem();
 #else
     fileSystem = new FileSystem(formatFlag);
+    if (remoteFileHost >= 0) {
+	fileSystem->MountRemote(remoteFileHost);
+    }
 #endif // FILESYS_STUB
 
-	// MP4 mod tag
-    /*
-	postOfficeIn = new PostOfficeInput(10);
-    postOfficeOut = new PostOfficeOutput(reliability);
-	*/
+    diskServer = NULL;
+    if (diskClientHost >= 0) {
+	diskServer = new DiskServer(diskClientHost);
+    }
+#ifndef FILESYS_STUB
+    for (unsigned i = 0; i < fileClientHosts.size(); i++) {
+	fileServers.push_back(new FileServer(fileClientHosts[i]));
+    }
+#endif
 
     interrupt->Enable();
 }
@@ -151,20 +227,68 @@ Kernel::~Kernel()
     delete scheduler;
     delete alarm;
     delete machine;
+    delete physPageMap;
     delete synchConsoleIn;
     delete synchConsoleOut;
     delete synchDisk;
     delete fileSystem;
 	
 	// Mp4 mod tag
-	/*
+	// only there if networkFlag was set; the sockets (or shared rings)
+	// are removed when they go
+    delete messageIn;
+    delete messageOut;
     delete postOfficeIn;
     delete postOfficeOut;
-    */
 	
     Exit(0);
 }
 
+//----------------------------------------------------------------------
+// ChurnThread
+//      Body of the threads forked by ThreadChurnTest -- just tell the
+//	parent that we ran, then finish.
+//----------------------------------------------------------------------
+
+static void
+ChurnThread(Semaphore *done)
+{
+    done->V();
+}
+
+//----------------------------------------------------------------------
+// ThreadChurnTest
+//      Fork and finish a large number of short-lived threads, a batch
+//	at a time, and report how many of their execution stacks had
+//	to be obtained from the host rather than from the stack pool.
+//----------------------------------------------------------------------
+
+static const int ChurnThreads = 1000;	// total # of threads to fork
+static const int ChurnBatch = 10;	// # of threads alive at once
+
+static void
+ThreadChurnTest()
+{
+    Semaphore *done = new Semaphore("churn", 0);
+    int allocated = kernel->stats->numStacksAllocated;
+    int reused = kernel->stats->numStacksReused;
+
+    for (int i = 0; i < ChurnThreads; i += ChurnBatch) {
+	for (int j = 0; j < ChurnBatch; j++) {
+	    Thread *t = kernel->NewThread("churn thread");
+	    t->Fork((VoidFunctionPtr) ChurnThread, (void *) done);
+	}
+	for (int j = 0; j < ChurnBatch; j++) {
+	    done->P();
+	}
+    }
+    delete done;
+
+    cout << "Thread churn: " << ChurnThreads << " threads, stacks allocated "
+	 << kernel->stats->numStacksAllocated - allocated << ", reused "
+	 << kernel->stats->numStacksReused - reused << "\n";
+}
+
 //----------------------------------------------------------------------
 // Kernel::ThreadSelfTest
 //      Test threads, semaphores, synchlists
@@ -190,6 +314,8 @@ Kernel::ThreadSelfTest() {
    synchList->SelfTest(9);
    delete synchList;
 
+   ThreadChurnTest();		// benchmark thread creation
+
 }
 
 //----------------------------------------------------------------------
@@ -224,8 +350,13 @@ Kernel::ConsoleTest() {
 //      3. send an acknowledgment for the other machine's message
 //      4. wait for an acknowledgement from the other machine to our 
 //          original message
+//      5. exchange a message too big for one packet, at mail box #2,
+//          and check that it arrives intact
+//      6. stream data both ways over a reliable connection between
+//          mail boxes #3, which survives packets lost by "-n"
 //
-//  This test works best if each Nachos machine has its own window
+//  This test works best if each Nachos machine has its own window.
+//  Give both machines "-shm" to run it over shared memory rings.
 //----------------------------------------------------------------------
 
 void
@@ -269,14 +400,186 @@ Kernel::NetworkTest() {
         cout << "Got: " << buffer << " : from " << inPktHdr.from << ", box " 
                                                 << inMailHdr.from << "\n";
         cout.flush();
+
+        // Send a large message, which has to go in fragments
+        const int bigSize = 1024;
+        char *big = new char[bigSize];
+        for (int i = 0; i < bigSize; i++) {
+            big[i] = (char)(i * 7 + hostName);
+        }
+        outPktHdr.to = farHost;
+        outMailHdr.to = 2;
+        outMailHdr.from = 2;
+        outMailHdr.length = bigSize;
+        messageOut->Send(outPktHdr, outMailHdr, big);
+
+        // Wait for the other machine's large message, and check it
+        int got = messageIn->Receive(2, &inPktHdr, &inMailHdr, big, bigSize);
+        bool intact = (got == bigSize);
+        for (int i = 0; intact && i < bigSize; i++) {
+            intact = (big[i] == (char)(i * 7 + farHost));
+        }
+        cout << "Got " << got << " byte message from " << inPktHdr.from
+             << (intact ? ", intact\n" : ", corrupted\n");
+        cout.flush();
+
+        // Stream the same amount over a reliable connection; it is
+        // left open, so the far end's last segments still get ACKed
+        ReliableConnection *conn = new ReliableConnection(postOfficeIn,
+                                        postOfficeOut, farHost, 3, 3);
+        for (int i = 0; i < bigSize; i++) {
+            big[i] = (char)(i * 7 + hostName);
+        }
+        conn->Send(big, bigSize);
+        conn->ReceiveAll(big, bigSize);
+        got = bigSize;
+        intact = TRUE;
+        for (int i = 0; intact && i < bigSize; i++) {
+            intact = (big[i] == (char)(i * 7 + farHost));
+        }
+        cout << "Got " << got << " byte stream from " << farHost
+             << (intact ? ", intact\n" : ", corrupted\n");
+        cout.flush();
+        delete [] big;
     }
 
     // Then we're done!
 }
 
+//----------------------------------------------------------------------
+// RpcEcho
+//	The procedure the RPC benchmark calls: return the arguments.
+//----------------------------------------------------------------------
+
+static int
+RpcEcho(void *arg, char *args, int argSize, char *result)
+{
+    bcopy(args, result, argSize);
+    return argSize;
+}
+
+// Work for one thread of the RPC throughput benchmark
+
+class RpcBenchmarkCaller {
+  public:
+    RpcClient *client;		// Shared by all the callers
+    int calls;			// Calls to make
+    int size;			// Bytes of arguments, and results, per call
+    int failures;		// Calls that timed out, or came back wrong
+    Semaphore *finished;	// V'ed when all the calls are made
+};
+
+static void
+RpcBenchmarkWorker(void *data)
+{
+    RpcBenchmarkCaller *caller = (RpcBenchmarkCaller *)data;
+    char *args = new char[caller->size];
+    char *result = new char[caller->size];
+
+    for (int i = 0; i < caller->calls; i++) {
+        for (int j = 0; j < caller->size; j++) {
+            args[j] = (char)(i + j);
+        }
+        int got = caller->client->Call(0, args, caller->size,
+                                       result, caller->size);
+        if (got != caller->size || bcmp(args, result, got) != 0) {
+            caller->failures++;
+        }
+    }
+    delete [] args;
+    delete [] result;
+    caller->finished->V();
+}
+
+//----------------------------------------------------------------------
+// Kernel::RpcTest
+//	Measure remote procedure calls between two copies of Nachos,
+//	machines 0 and 1.  Each serves an echo procedure on mailbox 0 and
+//	calls the other's from mailbox 1.
+//
+//	Latency is measured with one small call at a time.  Throughput is
+//	measured with RpcBenchCalls larger calls, made first by one thread
+//	and then split among several, whose calls are outstanding at the
+//	same time.
+//
+//	As in NetworkTest, the server and client are left running, so the
+//	far machine can finish its calls after we finish ours.
+//----------------------------------------------------------------------
+
+void
+Kernel::RpcTest() {
+    const int RpcLatencyCalls = 50;
+    const int RpcLatencySize = 16;
+    const int RpcBenchCalls = 64;
+    const int RpcBenchSize = 512;
+    const int RpcBenchCallers = 8;
+
+    if (hostName == 0 || hostName == 1) {
+        // if we're machine 1, call 0 and vice versa
+        int farHost = (hostName == 0 ? 1 : 0);
+        RpcServer *server = new RpcServer(0, RpcBenchCallers);
+        server->Register(0, RpcEcho, NULL);
+        RpcClient *client = new RpcClient(farHost, 0, 1);
+
+        // latency: one small call at a time
+        char args[RpcLatencySize], result[RpcLatencySize];
+        int failures = 0;
+        int start = stats->totalTicks;
+        for (int i = 0; i < RpcLatencyCalls; i++) {
+            for (int j = 0; j < RpcLatencySize; j++) {
+                args[j] = (char)(i * j);
+            }
+            int got = client->Call(0, args, RpcLatencySize,
+                                   result, RpcLatencySize);
+            if (got != RpcLatencySize || bcmp(args, result, got) != 0) {
+                failures++;
+            }
+        }
+        int ticks = stats->totalTicks - start;
+        cout << "RPC latency: " << RpcLatencyCalls << " calls of "
+             << RpcLatencySize << " bytes, " << ticks / RpcLatencyCalls
+             << " ticks per call, " << failures << " failed\n";
+
+        // throughput: the same calls, one caller and then several
+        for (int callers = 1; callers <= RpcBenchCallers;
+                                        callers *= RpcBenchCallers) {
+            RpcBenchmarkCaller *work = new RpcBenchmarkCaller[callers];
+            Semaphore *finished = new Semaphore("rpc benchmark", 0);
+
+            start = stats->totalTicks;
+            for (int i = 0; i < callers; i++) {
+                work[i].client = client;
+                work[i].calls = RpcBenchCalls / callers;
+                work[i].size = RpcBenchSize;
+                work[i].failures = 0;
+                work[i].finished = finished;
+                Thread *t = NewThread("rpc caller");
+                t->Fork(RpcBenchmarkWorker, &work[i]);
+            }
+            failures = 0;
+            for (int i = 0; i < callers; i++) {
+                finished->P();
+            }
+            ticks = stats->totalTicks - start;
+            for (int i = 0; i < callers; i++) {
+                failures += work[i].failures;
+            }
+            cout << "RPC throughput, " << callers << " caller(s): "
+                 << RpcBenchCalls << " calls of " << RpcBenchSize
+                 << " bytes in " << ticks << " ticks, "
+                 << (int)((double)RpcBenchCalls * RpcBenchSize * 1000 / ticks)
+                 << " bytes per 1000 ticks, " << failures << " failed\n";
+            cout.flush();
+            delete finished;
+            delete [] work;
+        }
+    }
+}
+
 void ForkExecute(Thread *t)
 {
 	if ( !t->space->Load(t->getName()) ) {
+		t->space->Exit(-1);
     	return;             // executable not found
     }
 	
@@ -286,8 +589,8 @@ void ForkExecute(Thread *t)
 
 void Kernel::ExecAll()
 {
-	for (int i=1;i<=execfileNum;i++) {
-		int a = Exec(execfile[i]);
+	for (unsigned int i = 0; i < execfile.size(); i++) {
+		Exec(execfile[i]);
 	}
 	currentThread->Finish();
     //Kernel::Exec();	
@@ -296,37 +599,233 @@ void Kernel::ExecAll()
 
 int Kernel::Exec(char* name)
 {
-	t[threadNum] = new Thread(name, threadNum);
-	t[threadNum]->space = new AddrSpace();
-	t[threadNum]->Fork((VoidFunctionPtr) &ForkExecute, (void *)t[threadNum]);
-	threadNum++;
-
-	return threadNum-1;
-/*
-    cout << "Total threads number is " << execfileNum << endl;
-    for (int n=1;n<=execfileNum;n++) {
-		t[n] = new Thread(execfile[n]);
-		t[n]->space = new AddrSpace();
-		t[n]->Fork((VoidFunctionPtr) &ForkExecute, (void *)t[n]);
-		cout << "Thread " << execfile[n] << " is executing." << endl;
+	return ExecV(1, &name);
+}
+
+//----------------------------------------------------------------------
+// Kernel::ExecV
+//	Start running the program in file argv[0], with arguments argv,
+//	in a new address space, and return its SpaceId without waiting
+//	for it to be loaded.  The program becomes a child of the current
+//	thread's program, which may collect its exit status with Join,
+//	and starts out sharing the parent's open files.
+//----------------------------------------------------------------------
+
+int Kernel::ExecV(int argc, char** argv)
+{
+	AddrSpace *space = new AddrSpace();
+	int spaceID;
+
+	if (!freeSpaceIDs.empty()) {
+		spaceID = freeSpaceIDs.back();
+		freeSpaceIDs.pop_back();
+	} else {
+		spaceID = spaceTable.size();
+		spaceTable.push_back(NULL);
+	}
+	spaceTable[spaceID] = space;
+	space->setID(spaceID);
+	if (currentThread->space != NULL) {
+		space->setParentID(currentThread->space->getID());
+		space->getFileTable()->Inherit(currentThread->space->getFileTable());
+	}
+	space->SetArguments(argc, argv);
+
+	Thread *t = NewThread(space->getProgramName());
+	t->space = space;
+	space->AddThread(t->getID(), -1);
+	t->Fork((VoidFunctionPtr) &ForkExecute, (void *)t);
+
+	return spaceID;
+}
+
+//----------------------------------------------------------------------
+// Kernel::Join
+//	Wait for child program "spaceID" of the current program to call
+//	Exit, and return its exit status.  A program can only be joined
+//	once; return -1 if "spaceID" is not a child we can join.
+//----------------------------------------------------------------------
+
+int Kernel::Join(int spaceID)
+{
+	AddrSpace *child = getSpace(spaceID);
+	int status;
+
+	if (child == NULL || currentThread->space == NULL ||
+			child->getParentID() != currentThread->space->getID() ||
+			child->IsJoined()) {
+		return -1;		// not ours, or somebody is already waiting
+	}
+	status = child->Join();
+	if (child->HasFinished()) {
+		FreeSpace(child);
+	} else {
+		child->setParentID(-1);	// cleaned up when its threads are done
+	}
+	return status;
+}
+
+//----------------------------------------------------------------------
+// Kernel::ProcessFinished
+//	Called when the last thread of a program has been deleted.  Give
+//	its memory back and close its files, and delete it right away
+//	unless its parent may still Join it.  Its children can no longer
+//	be joined.
+//----------------------------------------------------------------------
+
+void Kernel::ProcessFinished(AddrSpace* space)
+{
+	space->Exit(0);			// in case it never called Exit
+	space->ReleaseMemory();
+	space->getFileTable()->CloseAll();
+
+	for (unsigned int i = 0; i < spaceTable.size(); i++) {
+		AddrSpace *child = spaceTable[i];
+		if (child != NULL && child->getParentID() == space->getID()) {
+			if (child->HasFinished()) {
+				FreeSpace(child);
+			} else {
+				child->setParentID(-1);
+			}
+		}
+	}
+	if (space->getParentID() < 0) {
+		FreeSpace(space);
+	}
+}
+
+//----------------------------------------------------------------------
+// Kernel::getSpace
+//	Look up a program by its SpaceId.
+//----------------------------------------------------------------------
+
+AddrSpace *
+Kernel::getSpace(int spaceID)
+{
+	if (spaceID < 0 || spaceID >= (int) spaceTable.size()) {
+		return NULL;
+	}
+	return spaceTable[spaceID];
+}
+
+//----------------------------------------------------------------------
+// Kernel::FreeSpace
+//	Delete a program whose exit status is no longer wanted, and
+//	recycle its SpaceId.
+//----------------------------------------------------------------------
+
+void
+Kernel::FreeSpace(AddrSpace* space)
+{
+	spaceTable[space->getID()] = NULL;
+	freeSpaceIDs.push_back(space->getID());
+	delete space;
+}
+
+//----------------------------------------------------------------------
+// ForkUserThread
+//	Start running a thread forked by Kernel::ThreadFork.  Its user
+//	registers have been set up in its thread control block.
+//----------------------------------------------------------------------
+
+void ForkUserThread(Thread *t)
+{
+	kernel->scheduler->LoadUserState(t);
+	kernel->machine->Run();		// jump to the user procedure
+
+	ASSERTNOTREACHED();		// the thread leaves by ThreadExit
+}
+
+//----------------------------------------------------------------------
+// Kernel::ThreadFork
+//	Fork a user-level thread that shares the address space of the
+//	current thread, but has its own user stack and registers.
+//	Return its thread ID, or -1 if there is no room for its stack.
+//
+//	"func" is the user procedure the thread runs
+//	"retAddr" is where the user procedure returns to when it is done;
+//		the user stub points it at code that calls ThreadExit
+//----------------------------------------------------------------------
+
+int Kernel::ThreadFork(int func, int retAddr)
+{
+	AddrSpace *space = currentThread->space;
+	int stackTop = space->AllocThreadStack();
+
+	if (stackTop < 0) {
+		return -1;
+	}
+
+	Thread *t = NewThread(currentThread->getName());
+	t->space = space;
+	for (int i = 0; i < NumTotalRegs; i++) {
+		t->SetUserRegister(i, 0);
+	}
+	t->SetUserRegister(PCReg, func);
+	t->SetUserRegister(NextPCReg, func + 4);
+	t->SetUserRegister(StackReg, stackTop);
+	t->SetUserRegister(RetAddrReg, retAddr);
+	space->AddThread(t->getID(), stackTop);
+	t->Fork((VoidFunctionPtr) &ForkUserThread, (void *)t);
+
+	return t->getID();
+}
+
+//----------------------------------------------------------------------
+// Kernel::NewThread
+//	Create a thread and enter it in the thread table.  The ID of
+//	a deleted thread is handed out again before the table is grown,
+//	so the table stays as small as the number of live threads allows.
+//
+//	"name" is the name of the thread, useful for debugging
+//----------------------------------------------------------------------
+
+Thread *
+Kernel::NewThread(char* name)
+{
+	int threadID;
+
+	if (!freeThreadIDs.empty()) {
+		threadID = freeThreadIDs.back();
+		freeThreadIDs.pop_back();
+	} else {
+		threadID = threadTable.size();
+		threadTable.push_back(NULL);
+	}
+	threadTable[threadID] = new Thread(name, threadID);
+	return threadTable[threadID];
+}
+
+//----------------------------------------------------------------------
+// Kernel::FreeThreadID
+//	Remove a thread that is being deleted from the thread table, so
+//	that its ID can be reused.  Threads that were not created with
+//	NewThread are not in the table, and are ignored.
+//----------------------------------------------------------------------
+
+void
+Kernel::FreeThreadID(Thread* thread)
+{
+	int threadID = thread->getID();
+
+	if (getThread(threadID) == thread) {
+		threadTable[threadID] = NULL;
+		freeThreadIDs.push_back(threadID);
+	}
+}
+
+//----------------------------------------------------------------------
+// Kernel::getThread
+//	Look up a live thread by its ID.
+//----------------------------------------------------------------------
+
+Thread *
+Kernel::getThread(int threadID)
+{
+	if (threadID < 0 || threadID >= (int) threadTable.size()) {
+		return NULL;
 	}
-	cout << "debug Kernel::Run finished.\n";	
-*/
-//  Thread *t1 = new Thread(execfile[1]);
-//  Thread *t1 = new Thread("../test/test1");
-//  Thread *t2 = new Thread("../test/test2");
-
-//    AddrSpace *halt = new AddrSpace();
-//  t1->space = new AddrSpace();
-//  t2->space = new AddrSpace();
-
-//    halt->Execute("../test/halt");
-//  t1->Fork((VoidFunctionPtr) &ForkExecute, (void *)t1);
-//  t2->Fork((VoidFunctionPtr) &ForkExecute, (void *)t2);
-
-//	currentThread->Finish();
-//    Kernel::Run();
-//  cout << "after ThreadedKernel:Run();" << endl;  // unreachable
+	return threadTable[threadID];
 }
 
 #ifdef FILESYS_STUB
@@ -8,6 +8,7 @@
 #ifndef KERNEL_H
 #define KERNEL_H
 
+#include <vector>
 #include "copyright.h"
 #include "debug.h"
 #include "utility.h"
@@ -21,9 +22,14 @@
 
 class PostOfficeInput;
 class PostOfficeOutput;
+class MessageInput;
+class MessageOutput;
+class DiskServer;
+class FileServer;
 class SynchConsoleInput;
 class SynchConsoleOutput;
 class SynchDisk;
+class Bitmap;
 
 
 
@@ -42,11 +48,22 @@ class Kernel {
 	
 	void ExecAll();
 	int Exec(char* name);
+	int ExecV(int argc, char** argv);
+				// start a user program, return its SpaceId
+	int Join(int spaceID);	// wait for a child program to exit
+	void ProcessFinished(AddrSpace* space);
+				// last thread of a program is gone
+	int ThreadFork(int func, int retAddr);
+				// fork a user thread in the current
+				// thread's address space
     void ThreadSelfTest();	// self test of threads and synchronization
 	
     void ConsoleTest();         // interactive console self test
     void NetworkTest();         // interactive 2-machine network test
-	Thread* getThread(int threadID){return t[threadID];}    
+    void RpcTest();             // 2-machine RPC latency/throughput test
+	Thread* NewThread(char* name);	// create a thread with a fresh ID
+	void FreeThreadID(Thread* thread);	// thread is gone, recycle its ID
+	Thread* getThread(int threadID);	// NULL if no such thread
 
 	#ifdef FILESYS_STUB	
 	int CreateFile(char* filename); // fileSystem call
@@ -67,18 +84,39 @@ class Kernel {
     FileSystem *fileSystem;     
     PostOfficeInput *postOfficeIn;
     PostOfficeOutput *postOfficeOut;
+    MessageInput *messageIn;	// messages of any size, carried
+    MessageOutput *messageOut;	//   by the post office
+    Bitmap *physPageMap;	// physical pages in use by user programs
 
     int hostName;               // machine identifier
+    bool printStats;            // print statistics when halting
+    bool netSharedMemory;       // network runs over shared memory
+                                // rings instead of sockets
+    int remoteDiskHost;         // machine whose disk we use, -1 if
+                                // our disk is local
 
   private:
 
-	Thread* t[10];
-	char*   execfile[10];
-	int execfileNum;
-	int threadNum;
+	vector<Thread*> threadTable;	// live threads, indexed by thread ID
+	vector<int> freeThreadIDs;	// IDs of deleted threads, for reuse
+	vector<char*> execfile;		// programs to run, from "-e"
+	vector<AddrSpace*> spaceTable;	// programs, indexed by SpaceId
+	vector<int> freeSpaceIDs;	// SpaceIds of deleted programs
+	AddrSpace* getSpace(int spaceID);	// NULL if no such program
+	void FreeSpace(AddrSpace* space);	// delete the program, recycle
+					// its SpaceId
     bool randomSlice;		// enable pseudo-random time slicing
     bool debugUserProg;         // single step user program
     double reliability;         // likelihood messages are dropped
+    int netRingDepth;           // packets the network input can buffer
+    bool networkFlag;           // start the post office
+    int diskClientHost;         // machine we export our disk to, or -1
+    DiskServer *diskServer;     // serves our disk to diskClientHost
+#ifndef FILESYS_STUB
+    int remoteFileHost;         // machine whose files we use, or -1
+    vector<int> fileClientHosts; // machines we export our files to
+    vector<FileServer*> fileServers; // one per fileClientHosts entry
+#endif
     char *consoleIn;            // file to read console input from
     char *consoleOut;           // file to send console output to
 #ifndef FILESYS_STUB
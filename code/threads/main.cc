@@ -7,7 +7,10 @@
 //              -f -cp <unix file> <nachos file>
 //              -p <nachos file> -r <nachos file> -l -D
 //              -n <network reliability> -m <machine id>
-//              -z -K -C -N
+//              -nr <receive ring depth> -shm
+//              -dr <machine id> -ds <machine id>
+//              -fr <machine id> -fs <machine id>
+//              -z -K -C -N -R
 //
 //    -d causes certain debugging messages to be printed (see debug.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
@@ -18,9 +21,16 @@
 //    -co specify file for console output (stdout is the default)
 //    -n sets the network reliability
 //    -m sets this machine's host id (needed for the network)
+//    -nr sets how many arrived packets the network can buffer
+//    -shm runs the network over shared memory instead of sockets
+//    -dr uses the disk of another machine instead of a local one
+//    -ds exports this machine's disk to another machine
+//    -fr uses the files of another machine instead of local ones
+//    -fs exports this machine's files to another machine (may repeat)
 //    -K run a simple self test of kernel threads and synchronization
 //    -C run an interactive console test
 //    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -R run a two-machine RPC benchmark (see Kernel::RpcTest)
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
@@ -45,6 +55,7 @@
 #include "main.h"
 #include "filesys.h"
 #include "openfile.h"
+#include "synchdisk.h"
 #include "sysdep.h"
 
 // global variables
@@ -168,6 +179,7 @@ int main(int argc, char **argv)
     bool threadTestFlag = false;
     bool consoleTestFlag = false;
     bool networkTestFlag = false;
+    bool rpcTestFlag = false;
 #ifndef FILESYS_STUB
     char *copyUnixFileName = NULL;   // UNIX file to be copied into Nachos
     char *copyNachosFileName = NULL; // name of copied file in Nachos
@@ -218,6 +230,10 @@ int main(int argc, char **argv)
         {
             networkTestFlag = TRUE;
         }
+        else if (strcmp(argv[i], "-R") == 0)
+        {
+            rpcTestFlag = TRUE;
+        }
 #ifndef FILESYS_STUB
         else if (strcmp(argv[i], "-cp") == 0)
         {
@@ -320,6 +336,10 @@ int main(int argc, char **argv)
     {
         kernel->NetworkTest(); // two-machine test of the network
     }
+    if (rpcTestFlag)
+    {
+        kernel->RpcTest(); // two-machine RPC benchmark
+    }
 
 #ifndef FILESYS_STUB
     if (removeFileName != NULL)
@@ -352,6 +372,13 @@ int main(int argc, char **argv)
     }
 #endif // FILESYS_STUB
 
+    if (kernel->remoteDiskHost >= 0)
+    {
+        // with the network running, Nachos never halts by itself, so
+        // send what the commands above wrote to the disk server now
+        kernel->synchDisk->FlushAll();
+    }
+
     // finally, run an initial user program if requested to do so
 
     kernel->ExecAll();
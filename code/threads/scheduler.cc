@@ -33,6 +33,7 @@ Scheduler::Scheduler()
 { 
     readyList = new List<Thread *>; 
     toBeDestroyed = NULL;
+    userStateOwner = NULL;
 } 
 
 //----------------------------------------------------------------------
@@ -91,6 +92,11 @@ Scheduler::FindNextToRun ()
 //
 //      Note: we assume the state of the previously running thread has
 //	already been changed from running to blocked or ready (depending).
+//
+//	The user registers of a user program are not saved when its
+//	thread is switched out; they stay in the machine until another
+//	user thread needs it (see LoadUserState), so a trip through
+//	kernel-only threads and back costs no register copies.
 // Side effect:
 //	The global variable kernel->currentThread becomes nextThread.
 //
@@ -112,16 +118,12 @@ Scheduler::Run (Thread *nextThread, bool finishing)
 	 toBeDestroyed = oldThread;
     }
     
-    if (oldThread->space != NULL) {	// if this thread is a user program,
-        oldThread->SaveUserState(); 	// save the user's CPU registers
-	oldThread->space->SaveState();
-    }
-    
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
 
     kernel->currentThread = nextThread;  // switch to the next thread
     nextThread->setStatus(RUNNING);      // nextThread is now running
+    kernel->stats->numContextSwitches++;
     
     DEBUG(dbgThread, "Switching from: " << oldThread->getName() << " to: " << nextThread->getName());
     
@@ -144,8 +146,7 @@ Scheduler::Run (Thread *nextThread, bool finishing)
 					// and needs to be cleaned up
     
     if (oldThread->space != NULL) {	    // if there is an address space
-        oldThread->RestoreUserState();     // to restore, do it.
-	oldThread->space->RestoreState();
+        LoadUserState(oldThread);	    // to restore, do it.
     }
 }
 
@@ -161,11 +162,73 @@ void
 Scheduler::CheckToBeDestroyed()
 {
     if (toBeDestroyed != NULL) {
+	if (userStateOwner == toBeDestroyed) {	// its registers are dead
+	    userStateOwner = NULL;
+	}
         delete toBeDestroyed;
 	toBeDestroyed = NULL;
     }
 }
  
+//----------------------------------------------------------------------
+// Scheduler::LoadUserState
+// 	Make the machine hold the user registers and page table of
+//	"thread".  Nothing needs to be copied if it still holds them from
+//	the last time "thread" ran; otherwise the state of whichever user
+//	thread owns the machine is saved first.
+//
+//	"thread" is a thread with an address space, about to run user code
+//----------------------------------------------------------------------
+
+void
+Scheduler::LoadUserState(Thread *thread)
+{
+    if (userStateOwner == thread) {
+	kernel->stats->numUserStateSkips++;
+	return;
+    }
+    FlushUserState();
+    thread->RestoreUserState();
+    thread->space->RestoreState();
+    userStateOwner = thread;
+    kernel->stats->numUserStateRestores++;
+    kernel->stats->numUserRegsCopied += NumTotalRegs;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ClaimUserState
+// 	Give the machine to "thread", which will initialize the user
+//	registers itself (e.g., when starting a new program), after
+//	saving the state of the previous owner.
+//----------------------------------------------------------------------
+
+void
+Scheduler::ClaimUserState(Thread *thread)
+{
+    if (userStateOwner != thread) {
+	FlushUserState();
+	userStateOwner = thread;
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::FlushUserState
+// 	Save the user registers and address space state left in the
+//	machine by the thread that last ran user code, if any.
+//----------------------------------------------------------------------
+
+void
+Scheduler::FlushUserState()
+{
+    if (userStateOwner != NULL) {
+	userStateOwner->SaveUserState();
+	userStateOwner->space->SaveState();
+	userStateOwner = NULL;
+	kernel->stats->numUserStateSaves++;
+	kernel->stats->numUserRegsCopied += NumTotalRegs;
+    }
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Print
 // 	Print the scheduler state -- in other words, the contents of
@@ -30,6 +30,12 @@ class Scheduler {
     				// Cause nextThread to start running
     void CheckToBeDestroyed();// Check if thread that had been
     				// running needs to be deleted
+    void LoadUserState(Thread* thread);
+    				// Make sure the machine holds thread's
+				// user registers and page table
+    void ClaimUserState(Thread* thread);
+    				// thread is about to set up fresh user
+				// registers in the machine
     void Print();		// Print contents of ready list
     
     // SelfTest for scheduler is implemented in class Thread
@@ -39,6 +45,10 @@ class Scheduler {
 				// but not running
     Thread *toBeDestroyed;	// finishing thread to be destroyed
     				// by the next thread that runs
+    Thread *userStateOwner;	// thread whose user registers are
+    				// currently in the machine, if any
+    void FlushUserState();	// copy the owner's user registers
+    				// back into its thread control block
 };
 
 #endif // SCHEDULER_H
@@ -25,6 +25,58 @@
 // this is put at the top of the execution stack, for detecting stack overflows
 const int STACK_FENCEPOST = 0xdedbeef;
 
+// Pool of free execution stacks.  AllocBoundedArray costs an allocation
+// plus two mprotect calls, and DeallocBoundedArray two more, so instead
+// of handing a dead thread's stack back to the host we keep it, guard
+// pages and all, for the next thread that is forked.  The free stacks
+// are chained through their first word, which is overwritten with the
+// fencepost again once the stack is handed out.
+static int *freeStacks = NULL;		// head of the free stack chain
+static int numFreeStacks = 0;		// # of stacks on the chain
+
+//----------------------------------------------------------------------
+// StackPoolGet
+// 	Return a guarded execution stack, reusing a free one if we
+//	have any.
+//----------------------------------------------------------------------
+
+static int *
+StackPoolGet()
+{
+    int *stack;
+
+    if (freeStacks != NULL) {
+	stack = freeStacks;
+	freeStacks = *(int **) stack;
+	numFreeStacks--;
+	kernel->stats->numStacksReused++;
+    } else {
+	stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+	kernel->stats->numStacksAllocated++;
+    }
+    return stack;
+}
+
+//----------------------------------------------------------------------
+// StackPoolPut
+// 	Give an execution stack back to the pool.  Only once the pool
+//	is full is the stack (and its guard pages) released to the host.
+//
+//	"stack" is the stack to be recycled; no thread may be running on it
+//----------------------------------------------------------------------
+
+static void
+StackPoolPut(int *stack)
+{
+    if (numFreeStacks < StackPoolSize) {
+	*(int **) stack = freeStacks;
+	freeStacks = stack;
+	numFreeStacks++;
+    } else {
+	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+    }
+}
+
 //----------------------------------------------------------------------
 // Thread::Thread
 // 	Initialize a thread control block, so that we can then call
@@ -64,8 +116,15 @@ Thread::~Thread()
 {
     DEBUG(dbgThread, "Deleting thread: " << name);
     ASSERT(this != kernel->currentThread);
+    kernel->FreeThreadID(this);
+    if (space != NULL) {
+	space->ThreadExited(ID, 0);	// unless it already said how
+	if (space->DetachThread()) {
+	    kernel->ProcessFinished(space);	// last thread of its program
+	}
+    }
     if (stack != NULL)
-	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+	StackPoolPut(stack);
 }
 
 //----------------------------------------------------------------------
@@ -293,7 +352,8 @@ PLabelToAddr(void *plabel)
 
 //----------------------------------------------------------------------
 // Thread::StackAllocate
-//	Allocate and initialize an execution stack.  The stack is
+//	Allocate and initialize an execution stack, taking it from the
+//	stack pool when possible.  The stack is
 //	initialized with an initial stack frame for ThreadRoot, which:
 //		enables interrupts
 //		calls (*func)(arg)
@@ -306,7 +366,7 @@ PLabelToAddr(void *plabel)
 void
 Thread::StackAllocate (VoidFunctionPtr func, void *arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    stack = StackPoolGet();
 
 #ifdef PARISC
     // HP stack works from low addresses to high addresses
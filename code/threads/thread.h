@@ -57,6 +57,10 @@
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 const int StackSize = (8 * 1024);	// in words
 
+// Number of free execution stacks kept around for reuse by later threads.
+// Stacks beyond this are returned to the host.
+const int StackPoolSize = 32;
+
 
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED, ZOMBIE };
@@ -129,6 +133,9 @@ class Thread {
   public:
     void SaveUserState();		// save user-level register state
     void RestoreUserState();		// restore user-level register state
+    void SetUserRegister(int num, int value)
+	{ userRegisters[num] = value; }	// set up user state before the
+					// thread first runs user code
 
     AddrSpace *space;			// User code this thread is running.
 };
@@ -20,6 +20,8 @@
 #include "addrspace.h"
 #include "machine.h"
 #include "noff.h"
+#include "synch.h"
+#include "bitmap.h"
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -60,25 +62,33 @@ SwapHeader (NoffHeader *noffH)
 //----------------------------------------------------------------------
 // AddrSpace::AddrSpace
 // 	Create an address space to run a user program.
-//	Set up the translation from program memory to physical 
-//	memory.  For now, this is really simple (1:1), since we are
-//	only uniprogramming, and we have a single unsegmented page table
+//	Nothing is mapped yet; Load takes physical pages from
+//	kernel->physPageMap for the program, so that several programs
+//	can be in memory at once.  We have a single unsegmented page table.
 //----------------------------------------------------------------------
 
 AddrSpace::AddrSpace()
 {
     pageTable = new TranslationEntry[NumPhysPages];
     for (int i = 0; i < NumPhysPages; i++) {
-	pageTable[i].virtualPage = i;	// for now, virt page # = phys page #
-	pageTable[i].physicalPage = i;
-	pageTable[i].valid = TRUE;
+	pageTable[i].virtualPage = i;
+	pageTable[i].physicalPage = -1;
+	pageTable[i].valid = FALSE;
 	pageTable[i].use = FALSE;
 	pageTable[i].dirty = FALSE;
 	pageTable[i].readOnly = FALSE;  
     }
-    
-    // zero out the entire address space
-    bzero(kernel->machine->mainMemory, MemorySize);
+    numPages = 0;
+    numThreads = 0;
+
+    spaceID = parentID = -1;
+    argc = 0;
+    argv = NULL;
+    exitStatus = 0;
+    hasExited = FALSE;
+    isJoined = FALSE;
+    exited = new Semaphore("program exit", 0);
+    fileTable = new FileTable();
 }
 
 //----------------------------------------------------------------------
@@ -88,7 +98,21 @@ AddrSpace::AddrSpace()
 
 AddrSpace::~AddrSpace()
 {
-   delete pageTable;
+   ReleaseMemory();
+   if (kernel->machine->pageTable == pageTable) {  // don't leave the machine
+       kernel->machine->pageTable = NULL;	    // pointing at freed memory
+   }
+   delete [] pageTable;
+   for (int i = 0; i < argc; i++) {
+       delete [] argv[i];
+   }
+   delete [] argv;
+   delete exited;
+   delete fileTable;
+   for (unsigned int i = 0; i < threads.size(); i++) {
+       delete threads[i]->exited;
+       delete threads[i];
+   }
 }
 
 
@@ -132,30 +156,28 @@ AddrSpace::Load(char *fileName)
 			+ UserStackSize;	// we need to increase the size
 						// to leave room for the stack
 #endif
-    numPages = divRoundUp(size, PageSize);
+    // check we're not trying to run anything too big --
+    // at least until we have virtual memory
+    if (!AllocPages(0, divRoundUp(size, PageSize))) {
+	cerr << "Not enough memory for " << fileName << "\n";
+	delete executable;
+	return FALSE;
+    }
     size = numPages * PageSize;
 
-    ASSERT(numPages <= NumPhysPages);		// check we're not trying
-						// to run anything too big --
-						// at least until we have
-						// virtual memory
-
     DEBUG(dbgAddr, "Initializing address space: " << numPages << ", " << size);
 
 // then, copy in the code and data segments into memory
-// Note: this code assumes that virtual address = physical address
     if (noffH.code.size > 0) {
         DEBUG(dbgAddr, "Initializing code segment.");
 	DEBUG(dbgAddr, noffH.code.virtualAddr << ", " << noffH.code.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[noffH.code.virtualAddr]), 
+        LoadSegment(executable, noffH.code.virtualAddr,
 			noffH.code.size, noffH.code.inFileAddr);
     }
     if (noffH.initData.size > 0) {
         DEBUG(dbgAddr, "Initializing data segment.");
 	DEBUG(dbgAddr, noffH.initData.virtualAddr << ", " << noffH.initData.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[noffH.initData.virtualAddr]),
+        LoadSegment(executable, noffH.initData.virtualAddr,
 			noffH.initData.size, noffH.initData.inFileAddr);
     }
 
@@ -163,8 +185,7 @@ AddrSpace::Load(char *fileName)
     if (noffH.readonlyData.size > 0) {
         DEBUG(dbgAddr, "Initializing read only data segment.");
 	DEBUG(dbgAddr, noffH.readonlyData.virtualAddr << ", " << noffH.readonlyData.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[noffH.readonlyData.virtualAddr]),
+        LoadSegment(executable, noffH.readonlyData.virtualAddr,
 			noffH.readonlyData.size, noffH.readonlyData.inFileAddr);
     }
 #endif
@@ -187,9 +208,11 @@ AddrSpace::Execute(char* fileName)
 {
 
     kernel->currentThread->space = this;
+    kernel->scheduler->ClaimUserState(kernel->currentThread);
 
     this->InitRegisters();		// set the initial register values
     this->RestoreState();		// load page table register
+    this->PushArguments();		// pass argc, argv to main
 
     kernel->machine->Run();		// jump to the user progam
 
@@ -283,6 +306,10 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
 
     pte = &pageTable[vpn];
 
+    if(!pte->valid) {
+        return PageFaultException;
+    }
+
     if(isReadWrite && pte->readOnly) {
         return ReadOnlyException;
     }
@@ -311,6 +338,411 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
     return NoException;
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::AllocThreadStack
+//  Find a user stack for a new thread in this address space, and return
+//  its initial stack pointer.  The stack of an exited thread is reused
+//  if there is one; otherwise the address space is grown by
+//  UserStackSize.  Return -1 if physical memory is exhausted.
+//----------------------------------------------------------------------
+int
+AddrSpace::AllocThreadStack()
+{
+    int stackTop;
+    unsigned int stackPages = divRoundUp(UserStackSize, PageSize);
+
+    if (!freeStacks.empty()) {
+        stackTop = freeStacks.back();
+        freeStacks.pop_back();
+        return stackTop;
+    }
+    if (!AllocPages(numPages, stackPages)) {
+        return -1;
+    }
+    if (kernel->machine->pageTable == pageTable) {  // we are running
+        kernel->machine->pageTableSize = numPages;
+    }
+    DEBUG(dbgAddr, "Growing address space for thread stack: " << numPages);
+    return numPages * PageSize - 16;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AddThread
+//  Start keeping track of a thread running in this address space, in
+//  a new record.  An exited thread whose ID has been reused can no
+//  longer be named, so its record is dropped -- or, if threads are
+//  still on their way out of ThreadJoin on it, left for the last of
+//  them to drop.
+//
+//  "stackTop" is the stack from AllocThreadStack, or -1 if the thread
+//  runs on the stack set up by Load
+//----------------------------------------------------------------------
+void
+AddrSpace::AddThread(int threadID, int stackTop)
+{
+    UserThread *old = FindThread(threadID);
+    UserThread *thread = new UserThread;
+
+    if (old != NULL) {
+        ASSERT(old->hasExited);     // its Thread has been deleted
+        old->id = -1;               // only its joiners know it now
+        if (old->numJoiners == 0) {
+            RetireThread(old);
+        }
+    }
+    thread->id = threadID;
+    thread->stackTop = stackTop;
+    thread->exitCode = 0;
+    thread->hasExited = FALSE;
+    thread->exited = new Semaphore("user thread exit", 0);
+    thread->numJoiners = 0;
+    threads.push_back(thread);
+    numThreads++;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ThreadExited
+//  Record the exit code of a thread of this address space, give its
+//  stack back for reuse, and wake up any thread joining it.  Only the
+//  first call counts: the thread may have called ThreadExit or Exit
+//  before it is deleted (see Thread::~Thread).
+//----------------------------------------------------------------------
+void
+AddrSpace::ThreadExited(int threadID, int exitCode)
+{
+    UserThread *thread = FindThread(threadID);
+
+    if (thread == NULL || thread->hasExited) {
+        return;
+    }
+    thread->hasExited = TRUE;
+    thread->exitCode = exitCode;
+    if (thread->stackTop >= 0) {
+        freeStacks.push_back(thread->stackTop);
+        thread->stackTop = -1;
+    }
+    thread->exited->V();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ThreadJoin
+//  Wait until thread "threadID" of this address space has exited, and
+//  return its exit code.  Return -1 if there is no such thread, or it
+//  has already been joined.
+//
+//  Several threads may join the same thread at once; the last one out
+//  drops its record.
+//----------------------------------------------------------------------
+int
+AddrSpace::ThreadJoin(int threadID)
+{
+    UserThread *thread = FindThread(threadID);
+    int exitCode;
 
+    if (thread == NULL) {
+        return -1;
+    }
+    thread->numJoiners++;
+    thread->exited->P();
+    thread->exited->V();    // let any other joiner through too
+    exitCode = thread->exitCode;
+    if (--thread->numJoiners == 0) {
+        RetireThread(thread);
+    }
+    return exitCode;
+}
 
+//----------------------------------------------------------------------
+// AddrSpace::FindThread
+//  Return the record of thread "threadID", NULL if it never ran here
+//  or its record has been dropped.
+//----------------------------------------------------------------------
+UserThread *
+AddrSpace::FindThread(int threadID)
+{
+    for (unsigned int i = 0; i < threads.size(); i++) {
+        if (threads[i]->id == threadID) {
+            return threads[i];
+        }
+    }
+    return NULL;
+}
 
+//----------------------------------------------------------------------
+// AddrSpace::RetireThread
+//  Forget an exited thread that nobody can join any more.
+//----------------------------------------------------------------------
+void
+AddrSpace::RetireThread(UserThread *thread)
+{
+    ASSERT(thread->hasExited && thread->numJoiners == 0);
+    for (unsigned int i = 0; i < threads.size(); i++) {
+        if (threads[i] == thread) {
+            threads.erase(threads.begin() + i);
+            break;
+        }
+    }
+    delete thread->exited;
+    delete thread;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::DetachThread
+//  Called when a thread running in this address space is deleted.
+//  Return TRUE if no threads are left, in which case the caller
+//  should clean up the program (see Kernel::ProcessFinished).
+//----------------------------------------------------------------------
+bool
+AddrSpace::DetachThread()
+{
+    ASSERT(numThreads > 0);
+    numThreads--;
+    return numThreads == 0;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::SetArguments
+//  Save a copy of the arguments to pass to main(); the caller's
+//  strings may be gone by the time the program starts.
+//
+//  "argc", "argv" are the argument count and strings; argv[0] is the
+//  name of the program file
+//----------------------------------------------------------------------
+void
+AddrSpace::SetArguments(int argCount, char **argVector)
+{
+    ASSERT(argCount > 0 && argv == NULL);
+    argc = argCount;
+    argv = new char *[argc];
+    for (int i = 0; i < argc; i++) {
+        argv[i] = new char[strlen(argVector[i]) + 1];
+        strcpy(argv[i], argVector[i]);
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Exit
+//  The program is done; remember its exit status for Join.  Only the
+//  first call counts.
+//----------------------------------------------------------------------
+void
+AddrSpace::Exit(int status)
+{
+    if (!hasExited) {
+        hasExited = TRUE;
+        exitStatus = status;
+        exited->V();
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Join
+//  Wait until the program has called Exit, and return its status.
+//  IsJoined is TRUE from the moment somebody starts waiting.
+//----------------------------------------------------------------------
+int
+AddrSpace::Join()
+{
+    isJoined = TRUE;
+    exited->P();
+    exited->V();
+    return exitStatus;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ReleaseMemory
+//  Give the physical pages of the address space back to the kernel.
+//  Called once the last thread is gone; the AddrSpace itself may stay
+//  around until its exit status has been collected.
+//----------------------------------------------------------------------
+void
+AddrSpace::ReleaseMemory()
+{
+    for (unsigned int i = 0; i < numPages; i++) {
+        if (pageTable[i].valid) {
+            kernel->physPageMap->Clear(pageTable[i].physicalPage);
+            pageTable[i].valid = FALSE;
+        }
+    }
+    numPages = 0;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AllocPages
+//  Map "count" virtual pages starting at "firstPage" to free, zeroed
+//  physical pages, and grow the address space to cover them.  Return
+//  FALSE, mapping nothing, if there are not enough free pages.
+//----------------------------------------------------------------------
+bool
+AddrSpace::AllocPages(unsigned int firstPage, unsigned int count)
+{
+    if (firstPage + count > NumPhysPages ||
+        (int) count > kernel->physPageMap->NumClear()) {
+        return FALSE;
+    }
+    for (unsigned int i = firstPage; i < firstPage + count; i++) {
+        int frame = kernel->physPageMap->FindAndSet();
+        ASSERT(frame >= 0);
+        pageTable[i].physicalPage = frame;
+        pageTable[i].valid = TRUE;
+        bzero(&kernel->machine->mainMemory[frame * PageSize], PageSize);
+    }
+    numPages = firstPage + count;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::LoadSegment
+//  Read "size" bytes of the program file, starting at "inFileAddr",
+//  into the address space at "virtualAddr".  The pages need not be
+//  contiguous in physical memory, so we go a page at a time.
+//----------------------------------------------------------------------
+void
+AddrSpace::LoadSegment(OpenFile *executable, int virtualAddr, int size,
+                       int inFileAddr)
+{
+    while (size > 0) {
+        unsigned int paddr;
+        int chunk = PageSize - virtualAddr % PageSize;
+
+        if (chunk > size) {
+            chunk = size;
+        }
+        ASSERT(Translate(virtualAddr, &paddr, 0) == NoException);
+        executable->ReadAt(&(kernel->machine->mainMemory[paddr]), chunk,
+                           inFileAddr);
+        virtualAddr += chunk;
+        inFileAddr += chunk;
+        size -= chunk;
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PushArguments
+//  Copy the program arguments to the top of the user stack, and set
+//  up registers 4 and 5 so that main(argc, argv) finds them.
+//  Called after InitRegisters, while this address space is running.
+//
+//  The arguments must leave most of the stack to the program (SysExecV
+//  makes sure of that), or they would run into its data.
+//----------------------------------------------------------------------
+void
+AddrSpace::PushArguments()
+{
+    Machine *machine = kernel->machine;
+    int top = machine->ReadRegister(StackReg);
+    int sp = top;
+    int *argAddr = new int[argc + 1];
+    int i, word;
+    bool copied = TRUE;
+
+    for (i = 0; i < argc; i++) {
+        int len = strlen(argv[i]) + 1;
+        sp -= len;
+        copied = copied && CopyOut(sp, argv[i], len);
+        argAddr[i] = sp;
+    }
+    argAddr[argc] = 0;
+    sp -= sp % 4;			// word align the argv array
+
+    for (i = argc; i >= 0; i--) {
+        sp -= 4;
+        word = WordToMachine(argAddr[i]);
+        copied = copied && CopyOut(sp, (char *) &word, 4);
+    }
+    delete [] argAddr;
+    ASSERT(copied && top - sp <= UserStackSize / 2);
+
+    machine->WriteRegister(4, argc);
+    machine->WriteRegister(5, sp);
+    machine->WriteRegister(StackReg, sp - 16);	// room for main to save
+						// its argument registers
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyIn/CopyOut
+//  Copy "size" bytes from user virtual address "vaddr" into the
+//  kernel buffer "buf", or the other way around.  Each page touched
+//  is translated once, and the part of the range that lies in it is
+//  copied in one go -- consecutive virtual pages need not be
+//  consecutive in physical memory.
+//  Return FALSE if part of the range is not mapped.
+//----------------------------------------------------------------------
+bool
+AddrSpace::CopyIn(int vaddr, char *buf, int size)
+{
+    unsigned int paddr;
+
+    while (size > 0) {
+        int chunk = PageSize - (unsigned int) vaddr % PageSize;
+
+        if (chunk > size) {
+            chunk = size;
+        }
+        if (Translate(vaddr, &paddr, 0) != NoException) {
+            return FALSE;
+        }
+        bcopy(&kernel->machine->mainMemory[paddr], buf, chunk);
+        vaddr += chunk;
+        buf += chunk;
+        size -= chunk;
+    }
+    return TRUE;
+}
+
+bool
+AddrSpace::CopyOut(int vaddr, char *buf, int size)
+{
+    unsigned int paddr;
+
+    while (size > 0) {
+        int chunk = PageSize - (unsigned int) vaddr % PageSize;
+
+        if (chunk > size) {
+            chunk = size;
+        }
+        if (Translate(vaddr, &paddr, 1) != NoException) {
+            return FALSE;
+        }
+        bcopy(buf, &kernel->machine->mainMemory[paddr], chunk);
+        vaddr += chunk;
+        buf += chunk;
+        size -= chunk;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyInString
+//  Copy the null-terminated string at user address "vaddr" into "buf",
+//  a page at a time like CopyIn.
+//  Return FALSE if it is not mapped, or longer than maxSize-1 characters.
+//----------------------------------------------------------------------
+bool
+AddrSpace::CopyInString(int vaddr, char *buf, int maxSize)
+{
+    unsigned int paddr;
+
+    while (maxSize > 0) {
+        int chunk = PageSize - (unsigned int) vaddr % PageSize;
+        char *src, *end;
+
+        if (chunk > maxSize) {
+            chunk = maxSize;
+        }
+        if (Translate(vaddr, &paddr, 0) != NoException) {
+            return FALSE;
+        }
+        src = &kernel->machine->mainMemory[paddr];
+        end = (char *) memchr(src, '\0', chunk);
+        if (end != NULL) {
+            bcopy(src, buf, end - src + 1);
+            return TRUE;
+        }
+        bcopy(src, buf, chunk);
+        vaddr += chunk;
+        buf += chunk;
+        maxSize -= chunk;
+    }
+    return FALSE;
+}
@@ -15,9 +15,30 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "filetable.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
 
+class Semaphore;
+
+// The following class records a user-level thread running in an
+// address space, so that other threads of the same program can wait
+// for it to exit (see ThreadJoin) even after its Thread is deleted.
+// Each thread gets a record of its own, even if it reuses the ID of
+// one that exited; a record is deleted once the thread has been
+// joined, or once its ID has gone to another thread.
+
+class UserThread {
+  public:
+    int id;				// thread ID (see Kernel::NewThread)
+    int stackTop;			// initial stack pointer, or -1 if
+    					// the stack was not forked for it
+    int exitCode;			// argument to ThreadExit or Exit
+    bool hasExited;			// has exitCode been set?
+    Semaphore *exited;			// V'ed when the thread exits
+    int numJoiners;			// threads inside ThreadJoin on it
+};
+
 class AddrSpace {
   public:
     AddrSpace();			// Create an address space.
@@ -39,11 +60,78 @@ class AddrSpace {
     // is 0 for Read, 1 for Write.
     ExceptionType Translate(unsigned int vaddr, unsigned int *paddr, int mode);
 
+    // User-level threads sharing this address space
+
+    int AllocThreadStack();		// Return the initial stack pointer
+    					// for a new thread, -1 if no room
+    void AddThread(int threadID, int stackTop);
+    					// Start keeping track of a thread
+    void ThreadExited(int threadID, int exitCode);
+    					// Thread is done, wake up joiners
+    int ThreadJoin(int threadID);	// Wait for a thread of this space
+    					// to exit, return its exit code
+    bool DetachThread();		// A thread of this space has been
+    					// deleted; TRUE if it was the last
+
+    // The address space as a whole is a process, named by a SpaceId
+    // (see Kernel::ExecV)
+
+    int getID() { return spaceID; }
+    void setID(int id) { spaceID = id; }
+    int getParentID() { return parentID; }	// -1 if nobody will Join
+    void setParentID(int id) { parentID = id; }
+    void SetArguments(int argc, char **argv);
+    					// Copy the program arguments;
+					// argv[0] is the program file
+    char *getProgramName() { return argv[0]; }
+    bool HasFinished() { return numThreads == 0; }
+    void Exit(int status);		// Record the exit status, wake
+    					// up the joiner
+    int Join();				// Wait for Exit, return the status
+    bool IsJoined() { return isJoined; }
+    void ReleaseMemory();		// Give back the physical pages
+    FileTable *getFileTable() { return fileTable; }
+    					// The program's open files
+
+    // Move data between kernel buffers and this address space.
+    // Return FALSE if part of the user range is not mapped.
+
+    int Size() { return numPages * PageSize; }
+    					// Bytes in the address space; no
+					// user range can be longer
+    bool CopyIn(int vaddr, char *buf, int size);
+    bool CopyOut(int vaddr, char *buf, int size);
+    bool CopyInString(int vaddr, char *buf, int maxSize);
+    					// Copy a null-terminated string of
+					// at most maxSize-1 characters
+
   private:
     TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+    vector<UserThread *> threads;	// user threads, live or exited
+    vector<int> freeStacks;		// stacks of exited threads
+    int numThreads;			// threads not yet deleted
+
+    int spaceID;			// SpaceId of this program
+    int parentID;			// SpaceId of the program that may
+    					// Join us, -1 if none
+    int argc;				// program arguments
+    char **argv;
+    int exitStatus;			// argument to Exit
+    FileTable *fileTable;		// open files, by OpenFileId
+    bool hasExited;			// has Exit been called?
+    bool isJoined;			// has Join been called?
+    Semaphore *exited;			// V'ed on Exit
+
+    UserThread *FindThread(int threadID);
+    void RetireThread(UserThread *thread);
+    bool AllocPages(unsigned int firstPage, unsigned int count);
+    					// Map fresh physical pages
+    void LoadSegment(OpenFile *executable, int virtualAddr, int size,
+    		     int inFileAddr);	// Read part of the program file
+    void PushArguments();		// Copy argv onto the user stack
 
     void InitRegisters();		// Initialize user-level CPU registers,
 					// before jumping to user code
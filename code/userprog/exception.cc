@@ -4,8 +4,8 @@
 //	transfer back to here from user code:
 //
 //	syscall -- The user code explicitly requests to call a procedure
-//	in the Nachos kernel.  Right now, the only function we support is
-//	"Halt".
+//	in the Nachos kernel.  The calls we support are listed in
+//	syscallTable below.
 //
 //	exceptions -- The user code does something that the CPU can't handle.
 //	For instance, accessing memory that doesn't exist, arithmetic errors,
@@ -14,8 +14,7 @@
 //	Interrupts (which can also cause control to transfer from user
 //	code into the Nachos kernel) are handled elsewhere.
 //
-// For now, this only handles the Halt() system call.
-// Everything else core dumps.
+// Unknown system calls and all other exceptions core dump.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -25,6 +24,349 @@
 #include "main.h"
 #include "syscall.h"
 #include "ksyscall.h"
+
+// Longest string (including the terminating null) MSG will print
+static const int MaxMessageSize = 256;
+
+//----------------------------------------------------------------------
+// System call handlers
+//	Each handler receives the syscall arguments already read out of
+//	r4..r7 and returns the value to be placed in r2.  Handlers for
+//	calls that never come back (Halt, Exit, ...) simply don't return.
+//	Arguments a handler doesn't use are ignored.
+//----------------------------------------------------------------------
+
+typedef int (*SyscallHandler)(int arg1, int arg2, int arg3, int arg4);
+
+static int
+HandleHalt(int, int, int, int)
+{
+	DEBUG(dbgSys, "Shutdown, initiated by user program.\n");
+	SysHalt();
+	ASSERTNOTREACHED();
+	return 0;
+}
+
+static int
+HandleMSG(int msgAddr, int, int, int)
+{
+	char msg[MaxMessageSize];
+
+	DEBUG(dbgSys, "Message received.\n");
+	kernel->synchConsoleOut->Flush();
+	if (kernel->currentThread->space->CopyInString(msgAddr, msg, MaxMessageSize))
+		cout << msg << endl;
+	SysHalt();
+	ASSERTNOTREACHED();
+	return 0;
+}
+
+// MP4 mod tag
+#ifdef FILESYS_STUB
+static int
+HandleCreate(int nameAddr, int, int, int)
+{
+	char filename[PATH_NAME_MAX_LEN + 1];
+
+	if (!kernel->currentThread->space->CopyInString(nameAddr, filename, PATH_NAME_MAX_LEN + 1))
+		return 0;
+	return SysCreate(filename);
+}
+#else
+static int
+HandleCreate(int nameAddr, int initialSize, int, int)
+{
+	char filename[PATH_NAME_MAX_LEN + 1];
+
+	if (!kernel->currentThread->space->CopyInString(nameAddr, filename, PATH_NAME_MAX_LEN + 1))
+		return 0;
+	return SysCreate(filename, initialSize);
+}
+
+static int
+HandleOpen(int nameAddr, int, int, int)
+{
+	char filename[PATH_NAME_MAX_LEN + 1];
+
+	if (!kernel->currentThread->space->CopyInString(nameAddr, filename, PATH_NAME_MAX_LEN + 1))
+		return -1;
+	return SysOpen(filename);
+}
+
+static int
+HandleWrite(int bufAddr, int numChar, int fileID, int)
+{
+	int status = -1;
+
+	if (numChar >= 0 && numChar <= kernel->currentThread->space->Size())
+	{
+		char *buffer = new char[numChar];
+		if (kernel->currentThread->space->CopyIn(bufAddr, buffer, numChar))
+			status = SysWrite(buffer, numChar, fileID);
+		delete[] buffer;
+	}
+	return status;
+}
+
+static int
+HandleRead(int bufAddr, int numChar, int fileID, int)
+{
+	int status = -1;
+
+	if (numChar >= 0 && numChar <= kernel->currentThread->space->Size())
+	{
+		char *buffer = new char[numChar];
+		status = SysRead(buffer, numChar, fileID);
+		if (status > 0 && !kernel->currentThread->space->CopyOut(bufAddr, buffer, status))
+			status = -1;
+		delete[] buffer;
+	}
+	return status;
+}
+
+static int
+HandleSeek(int position, int fileID, int, int)
+{
+	return SysSeek(position, fileID);
+}
+
+static int
+HandlePWrite(int bufAddr, int numChar, int position, int fileID)
+{
+	int status = -1;
+
+	if (numChar >= 0 && numChar <= kernel->currentThread->space->Size())
+	{
+		char *buffer = new char[numChar];
+		if (kernel->currentThread->space->CopyIn(bufAddr, buffer, numChar))
+			status = SysPWrite(buffer, numChar, position, fileID);
+		delete[] buffer;
+	}
+	return status;
+}
+
+static int
+HandlePRead(int bufAddr, int numChar, int position, int fileID)
+{
+	int status = -1;
+
+	if (numChar >= 0 && numChar <= kernel->currentThread->space->Size())
+	{
+		char *buffer = new char[numChar];
+		status = SysPRead(buffer, numChar, position, fileID);
+		if (status > 0 && !kernel->currentThread->space->CopyOut(bufAddr, buffer, status))
+			status = -1;
+		delete[] buffer;
+	}
+	return status;
+}
+
+static int
+HandleWriteV(int iovAddr, int count, int fileID, int)
+{
+	return SysWriteV(iovAddr, count, fileID);
+}
+
+static int
+HandleReadV(int iovAddr, int count, int fileID, int)
+{
+	return SysReadV(iovAddr, count, fileID);
+}
+
+static int
+HandleCopyFileRange(int inID, int outID, int size, int)
+{
+	return SysCopyFileRange(inID, outID, size);
+}
+
+static int
+HandleIoSubmit(int ringAddr, int, int, int)
+{
+	return SysIoSubmit(ringAddr);
+}
+
+static int
+HandleFsync(int fileID, int, int, int)
+{
+	return SysFsync(fileID);
+}
+
+static int
+HandleSync(int, int, int, int)
+{
+	SysSync();
+	return 0;
+}
+
+static int
+HandleDup(int fileID, int, int, int)
+{
+	return SysDup(fileID);
+}
+
+static int
+HandleClose(int fileID, int, int, int)
+{
+	return SysClose(fileID);
+}
+#endif
+
+static int
+HandleAdd(int op1, int op2, int, int)
+{
+	int result;
+
+	DEBUG(dbgSys, "Add " << op1 << " + " << op2 << "\n");
+	result = SysAdd(op1, op2);
+	DEBUG(dbgSys, "Add returning with " << result << "\n");
+	cout << "result is " << result << "\n";
+	return result;
+}
+
+static int
+HandleTicks(int, int, int, int)
+{
+	return SysTicks();
+}
+
+static int
+HandleThreadFork(int func, int retAddr, int, int)
+{
+	return SysThreadFork(func, retAddr);
+}
+
+static int
+HandleThreadYield(int, int, int, int)
+{
+	SysThreadYield();
+	return 0;
+}
+
+static int
+HandleThreadExit(int exitCode, int, int, int)
+{
+	DEBUG(dbgSys, "Thread exit\n");
+	SysThreadExit(exitCode);
+	ASSERTNOTREACHED();
+	return 0;
+}
+
+static int
+HandleThreadJoin(int threadID, int, int, int)
+{
+	return SysThreadJoin(threadID);
+}
+
+static int
+HandleExec(int nameAddr, int, int, int)
+{
+	char filename[PATH_NAME_MAX_LEN + 1];
+
+	if (!kernel->currentThread->space->CopyInString(nameAddr, filename, PATH_NAME_MAX_LEN + 1))
+		return -1;
+	return SysExec(filename);
+}
+
+static int
+HandleExecV(int argc, int argvAddr, int, int)
+{
+	return SysExecV(argc, argvAddr);
+}
+
+static int
+HandleJoin(int programID, int, int, int)
+{
+	return SysJoin(programID);
+}
+
+static int
+HandleExit(int status, int, int, int)
+{
+	DEBUG(dbgAddr, "Program exit\n");
+	SysExit(status);
+	ASSERTNOTREACHED();
+	return 0;
+}
+
+//----------------------------------------------------------------------
+// syscallTable
+//	Maps a system call code (see syscall.h) to its handler.  numArgs
+//	says how many of r4..r7 the handler looks at, so that we only read
+//	the registers we need.  Codes with no entry are unimplemented.
+//----------------------------------------------------------------------
+
+struct SyscallEntry
+{
+	const char *name;
+	int numArgs;
+	SyscallHandler handler;
+};
+
+static SyscallEntry syscallTable[NumSyscallCodes];
+
+//----------------------------------------------------------------------
+// RegisterSyscall
+// 	Install one entry in syscallTable.
+//----------------------------------------------------------------------
+
+static void
+RegisterSyscall(int type, const char *name, int numArgs, SyscallHandler handler)
+{
+	ASSERT(type >= 0 && type < NumSyscallCodes);
+	ASSERT(numArgs >= 0 && numArgs <= 4);
+	syscallTable[type].name = name;
+	syscallTable[type].numArgs = numArgs;
+	syscallTable[type].handler = handler;
+	kernel->stats->syscallNames[type] = name;
+}
+
+//----------------------------------------------------------------------
+// InitSyscallTable
+// 	Fill in syscallTable the first time a system call is made.
+//----------------------------------------------------------------------
+
+static void
+InitSyscallTable()
+{
+	static bool initialized = FALSE;
+
+	if (initialized)
+		return;
+	initialized = TRUE;
+
+	RegisterSyscall(SC_Halt, "Halt", 0, HandleHalt);
+	RegisterSyscall(SC_MSG, "MSG", 1, HandleMSG);
+#ifdef FILESYS_STUB
+	RegisterSyscall(SC_Create, "Create", 1, HandleCreate);
+#else
+	RegisterSyscall(SC_Create, "Create", 2, HandleCreate);
+	RegisterSyscall(SC_Open, "Open", 1, HandleOpen);
+	RegisterSyscall(SC_Write, "Write", 3, HandleWrite);
+	RegisterSyscall(SC_Read, "Read", 3, HandleRead);
+	RegisterSyscall(SC_Seek, "Seek", 2, HandleSeek);
+	RegisterSyscall(SC_PWrite, "PWrite", 4, HandlePWrite);
+	RegisterSyscall(SC_PRead, "PRead", 4, HandlePRead);
+	RegisterSyscall(SC_WriteV, "WriteV", 3, HandleWriteV);
+	RegisterSyscall(SC_ReadV, "ReadV", 3, HandleReadV);
+	RegisterSyscall(SC_CopyFileRange, "CopyFileRange", 3, HandleCopyFileRange);
+	RegisterSyscall(SC_IoSubmit, "IoSubmit", 1, HandleIoSubmit);
+	RegisterSyscall(SC_Fsync, "Fsync", 1, HandleFsync);
+	RegisterSyscall(SC_Sync, "Sync", 0, HandleSync);
+	RegisterSyscall(SC_Dup, "Dup", 1, HandleDup);
+	RegisterSyscall(SC_Close, "Close", 1, HandleClose);
+#endif
+	RegisterSyscall(SC_Add, "Add", 2, HandleAdd);
+	RegisterSyscall(SC_Ticks, "Ticks", 0, HandleTicks);
+	RegisterSyscall(SC_ThreadFork, "ThreadFork", 2, HandleThreadFork);
+	RegisterSyscall(SC_ThreadYield, "ThreadYield", 0, HandleThreadYield);
+	RegisterSyscall(SC_ThreadExit, "ThreadExit", 1, HandleThreadExit);
+	RegisterSyscall(SC_ThreadJoin, "ThreadJoin", 1, HandleThreadJoin);
+	RegisterSyscall(SC_Exec, "Exec", 1, HandleExec);
+	RegisterSyscall(SC_ExecV, "ExecV", 2, HandleExecV);
+	RegisterSyscall(SC_Join, "Join", 1, HandleJoin);
+	RegisterSyscall(SC_Exit, "Exit", 1, HandleExit);
+}
+
 //----------------------------------------------------------------------
 // ExceptionHandler
 // 	Entry point into the Nachos kernel.  Called when a user program
@@ -41,8 +383,11 @@
 //
 //	The result of the system call, if any, must be put back into r2.
 //
-// If you are handling a system call, don't forget to increment the pc
-// before returning. (Or else you'll loop making the same system call forever!)
+//	System calls are dispatched through syscallTable; every handler
+//	that returns shares the same epilogue, which stores the result and
+//	advances the pc (or else we'd loop making the same system call
+//	forever!).  The number of calls and the ticks spent in each are
+//	recorded in kernel->stats.
 //
 //	"which" is the kind of exception.  The list of possible exceptions
 //	is in machine.h.
@@ -50,154 +395,37 @@
 
 void ExceptionHandler(ExceptionType which)
 {
-	int type = kernel->machine->ReadRegister(2);
-	int val, initialSize;
-	int status, exit, threadID, programID, fileID, numChar;
+	Machine *machine = kernel->machine;
+	int type = machine->ReadRegister(2);
+	int arg[4] = {0, 0, 0, 0};
+	int result, startTicks;
+	SyscallEntry *entry;
+
 	DEBUG(dbgSys, "Received Exception " << which << " type: " << type << "\n");
 	switch (which)
 	{
 	case SyscallException:
-		switch (type)
+		InitSyscallTable();
+		if (type < 0 || type >= NumSyscallCodes || syscallTable[type].handler == NULL)
 		{
-		case SC_Halt:
-			DEBUG(dbgSys, "Shutdown, initiated by user program.\n");
-			SysHalt();
-			cout << "in exception\n";
-			ASSERTNOTREACHED();
-			break;
-		case SC_MSG:
-			DEBUG(dbgSys, "Message received.\n");
-			val = kernel->machine->ReadRegister(4);
-			{
-				char *msg = &(kernel->machine->mainMemory[val]);
-				cout << msg << endl;
-			}
-			SysHalt();
-			ASSERTNOTREACHED();
-			break;
-			// MP4 mod tag
-#ifdef FILESYS_STUB
-		case SC_Create:
-			val = kernel->machine->ReadRegister(4);
-			{
-				char *filename = &(kernel->machine->mainMemory[val]);
-				// cout << filename << endl;
-				status = SysCreate(filename);
-				kernel->machine->WriteRegister(2, (int)status);
-			}
-			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
-			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
-			return;
-			ASSERTNOTREACHED();
-			break;
-#else
-		case SC_Create:
-			val = kernel->machine->ReadRegister(4);
-			initialSize = kernel->machine->ReadRegister(5);
-			{
-				char *filename = &(kernel->machine->mainMemory[val]);
-				// cout << filename << endl;
-				status = SysCreate(filename, initialSize);
-				kernel->machine->WriteRegister(2, (int)status);
-			}
-			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
-			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
-			return;
-			ASSERTNOTREACHED();
-			break;
-		case SC_Open:
-			val = kernel->machine->ReadRegister(4);
-			{
-				char *filename = &(kernel->machine->mainMemory[val]);
-				status = SysOpen(filename);
-				kernel->machine->WriteRegister(2, (int)status);
-			}
-			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
-			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
-			return;
-			ASSERTNOTREACHED();
-			break;
-		case SC_Write:
-			val = kernel->machine->ReadRegister(4);
-			{
-				char *buffer = &(kernel->machine->mainMemory[val]);
-				numChar = kernel->machine->ReadRegister(5);
-				fileID = kernel->machine->ReadRegister(6);
-				status = SysWrite(buffer, numChar, fileID);
-				kernel->machine->WriteRegister(2, (int)status);
-			}
-			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
-			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
-			return;
-			ASSERTNOTREACHED();
-			break;
-		case SC_Read:
-			val = kernel->machine->ReadRegister(4);
-			{
-				char *buffer = &(kernel->machine->mainMemory[val]);
-				numChar = kernel->machine->ReadRegister(5);
-				fileID = kernel->machine->ReadRegister(6);
-				status = SysRead(buffer, numChar, fileID);
-				kernel->machine->WriteRegister(2, (int)status);
-			}
-			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
-			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
-			return;
-			ASSERTNOTREACHED();
-			break;
-		case SC_Close:
-			fileID = kernel->machine->ReadRegister(4);
-			{
-				status = SysClose(fileID);
-				kernel->machine->WriteRegister(2, (int)status);
-			}
-			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
-			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
-			return;
-			ASSERTNOTREACHED();
-			break;
-#endif
-		case SC_Add:
-			DEBUG(dbgSys, "Add " << kernel->machine->ReadRegister(4) << " + " << kernel->machine->ReadRegister(5) << "\n");
-			/* Process SysAdd Systemcall*/
-			int result;
-			result = SysAdd(/* int op1 */ (int)kernel->machine->ReadRegister(4),
-							/* int op2 */ (int)kernel->machine->ReadRegister(5));
-			DEBUG(dbgSys, "Add returning with " << result << "\n");
-			/* Prepare Result */
-			kernel->machine->WriteRegister(2, (int)result);
-			/* Modify return point */
-			{
-				/* set previous programm counter (debugging only)*/
-				kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-
-				/* set programm counter to next instruction (all Instructions are 4 byte wide)*/
-				kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
-
-				/* set next programm counter for brach execution */
-				kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
-			}
-			cout << "result is " << result << "\n";
-			return;
-			ASSERTNOTREACHED();
-			break;
-		case SC_Exit:
-			DEBUG(dbgAddr, "Program exit\n");
-			val = kernel->machine->ReadRegister(4);
-			cout << "return value:" << val << endl;
-			kernel->currentThread->Finish();
-			break;
-		default:
 			cerr << "Unexpected system call " << type << "\n";
 			break;
 		}
-		break;
+		entry = &syscallTable[type];
+		for (int i = 0; i < entry->numArgs; i++)
+			arg[i] = machine->ReadRegister(4 + i);
+		DEBUG(dbgSys, "Syscall " << entry->name << "\n");
+
+		kernel->stats->numSyscalls[type]++;
+		startTicks = kernel->stats->totalTicks;
+		result = (*entry->handler)(arg[0], arg[1], arg[2], arg[3]);
+		kernel->stats->syscallTicks[type] += kernel->stats->totalTicks - startTicks;
+
+		machine->WriteRegister(2, result);
+		machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
+		machine->WriteRegister(PCReg, machine->ReadRegister(PCReg) + 4);
+		machine->WriteRegister(NextPCReg, machine->ReadRegister(PCReg) + 4);
+		return;
 	default:
 		cerr << "Unexpected user mode exception " << (int)which << "\n";
 		break;
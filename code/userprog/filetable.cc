@@ -0,0 +1,280 @@
+// filetable.cc
+//	Routines to manage the open files of a user program.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "filetable.h"
+#include "syscall.h"
+#include "synchconsole.h"
+
+// Lowest id handed out for a file; the ones below are the console's
+static const int FirstFileId = SysConsoleOutput + 1;
+
+//----------------------------------------------------------------------
+// FileTable::FileTable
+// 	Initialize an empty table, with the console ids reserved.
+//----------------------------------------------------------------------
+
+FileTable::FileTable()
+{
+    files.resize(FirstFileId, NULL);
+}
+
+//----------------------------------------------------------------------
+// FileTable::~FileTable
+// 	Drop our reference to every file still open.
+//----------------------------------------------------------------------
+
+FileTable::~FileTable()
+{
+    CloseAll();
+}
+
+//----------------------------------------------------------------------
+// FileTable::Open
+// 	Open the Nachos file "name" and give it an id.  Return -1 if the
+//	file doesn't exist.
+//----------------------------------------------------------------------
+
+OpenFileId
+FileTable::Open(char *name)
+{
+    OpenFile *file = kernel->fileSystem->Open(name);
+
+    if (file == NULL) {
+	return -1;
+    }
+    return Add(file);
+}
+
+//----------------------------------------------------------------------
+// FileTable::Add
+// 	Put "file" in the lowest free slot, growing the table if it is
+//	full.  The table now owns the reference the caller held.
+//----------------------------------------------------------------------
+
+OpenFileId
+FileTable::Add(OpenFile *file)
+{
+    unsigned int id;
+
+    for (id = FirstFileId; id < files.size(); id++) {
+	if (files[id] == NULL) {
+	    break;
+	}
+    }
+    if (id == files.size()) {
+	files.push_back(NULL);
+    }
+    files[id] = file;
+    return id;
+}
+
+//----------------------------------------------------------------------
+// FileTable::Get
+// 	Return the open file with id "id", or NULL if there is none.
+//----------------------------------------------------------------------
+
+OpenFile *
+FileTable::Get(OpenFileId id)
+{
+    if (id < 0 || id >= (int) files.size()) {
+	return NULL;
+    }
+    return files[id];
+}
+
+//----------------------------------------------------------------------
+// FileTable::Close
+// 	Free id "id", and close the file once no id refers to it.
+//----------------------------------------------------------------------
+
+int
+FileTable::Close(OpenFileId id)
+{
+    OpenFile *file = Get(id);
+
+    if (file == NULL) {
+	return -1;
+    }
+    files[id] = NULL;
+    if (file->Release()) {
+	delete file;
+    }
+    return 1;
+}
+
+//----------------------------------------------------------------------
+// FileTable::Dup
+// 	Give the open file "id" a second id, sharing its seek position.
+//----------------------------------------------------------------------
+
+OpenFileId
+FileTable::Dup(OpenFileId id)
+{
+    OpenFile *file = Get(id);
+
+    if (file == NULL) {
+	return -1;
+    }
+    file->Retain();
+    return Add(file);
+}
+
+//----------------------------------------------------------------------
+// FileTable::Inherit
+// 	Give this (new, empty) table the same ids for the same open files
+//	as "parent".
+//----------------------------------------------------------------------
+
+void
+FileTable::Inherit(FileTable *parent)
+{
+    CloseAll();
+    files.resize(parent->files.size(), NULL);
+    for (unsigned int id = 0; id < files.size(); id++) {
+	files[id] = parent->files[id];
+	if (files[id] != NULL) {
+	    files[id]->Retain();
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// FileTable::CloseAll
+// 	Close every id, as when the program finishes.
+//----------------------------------------------------------------------
+
+void
+FileTable::CloseAll()
+{
+    for (unsigned int id = 0; id < files.size(); id++) {
+	if (files[id] != NULL) {
+	    Close(id);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// FileTable::Read/Write
+// 	Read/write "size" bytes at the seek position of open file "id".
+//	Return the number of bytes transferred, or -1 if "id" is not open.
+//
+//	SysConsoleInput reads a line from the console, and output to
+//	SysConsoleOutput is line buffered (see SynchConsoleOutput).
+//----------------------------------------------------------------------
+
+int
+FileTable::Read(OpenFileId id, char *buffer, int size)
+{
+    OpenFile *file = Get(id);
+
+    if (id == SysConsoleInput && size >= 0) {
+	kernel->synchConsoleOut->Flush();	// show any prompt first
+	return kernel->synchConsoleIn->GetString(buffer, size);
+    }
+    if (file == NULL || size < 0) {
+	return -1;
+    }
+    return file->Read(buffer, size);
+}
+
+int
+FileTable::Write(OpenFileId id, char *buffer, int size)
+{
+    OpenFile *file = Get(id);
+
+    if (id == SysConsoleOutput && size >= 0) {
+	kernel->synchConsoleOut->PutString(buffer, size);
+	return size;
+    }
+    if (file == NULL || size < 0) {
+	return -1;
+    }
+    return file->Write(buffer, size);
+}
+
+//----------------------------------------------------------------------
+// FileTable::ReadAt/WriteAt
+// 	Like Read/Write, but at "position", leaving the seek position alone.
+//----------------------------------------------------------------------
+
+int
+FileTable::ReadAt(OpenFileId id, char *buffer, int size, int position)
+{
+    OpenFile *file = Get(id);
+
+    if (file == NULL || size < 0 || position < 0) {
+	return -1;
+    }
+    return file->ReadAt(buffer, size, position);
+}
+
+int
+FileTable::WriteAt(OpenFileId id, char *buffer, int size, int position)
+{
+    OpenFile *file = Get(id);
+
+    if (file == NULL || size < 0 || position < 0) {
+	return -1;
+    }
+    return file->WriteAt(buffer, size, position);
+}
+
+//----------------------------------------------------------------------
+// FileTable::Seek
+// 	Move the seek position of open file "id".  Return the new
+//	position, or -1.
+//----------------------------------------------------------------------
+
+int
+FileTable::Seek(OpenFileId id, int position)
+{
+    OpenFile *file = Get(id);
+
+    if (file == NULL || position < 0) {
+	return -1;
+    }
+    file->Seek(position);
+    return position;
+}
+
+//----------------------------------------------------------------------
+// FileTable::Sync
+// 	Flush the buffered writes of open file "id" to disk.  Return 1,
+//	or -1 if "id" is not open.
+//----------------------------------------------------------------------
+
+int
+FileTable::Sync(OpenFileId id)
+{
+    OpenFile *file = Get(id);
+
+    if (file == NULL) {
+	return -1;
+    }
+    file->Sync();
+    return 1;
+}
+
+//----------------------------------------------------------------------
+// FileTable::CopyRange
+// 	Copy "size" bytes between two different open files (see
+//	FileSystem::CopyFileRange).
+//----------------------------------------------------------------------
+
+int
+FileTable::CopyRange(OpenFileId inId, OpenFileId outId, int size)
+{
+    OpenFile *in = Get(inId);
+    OpenFile *out = Get(outId);
+
+    if (in == NULL || out == NULL || in == out || size < 0) {
+	return -1;
+    }
+    return kernel->fileSystem->CopyFileRange(in, out, size);
+}
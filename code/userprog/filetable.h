@@ -0,0 +1,52 @@
+// filetable.h
+//	Data structures for the open files of a user program.
+//
+//	Each program has its own table mapping OpenFileIds to open
+//	files, growing as more files are opened.  The OpenFile objects
+//	themselves are reference counted, so that a Dup'ed id, or an id
+//	a child program inherited from its parent at Exec, shares the
+//	same file and seek position as the original.
+//
+//	Ids 0 and 1 are the console (see syscall.h): Read and Write on
+//	them go to the keyboard and display.  Files get the lowest free
+//	id above those.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FILETABLE_H
+#define FILETABLE_H
+
+#include <vector>
+#include "copyright.h"
+#include "filesys.h"
+
+class FileTable {
+  public:
+    FileTable();			// Nothing open yet
+    ~FileTable();			// Close everything still open
+
+    OpenFileId Open(char *name);	// Open a file, return its id or -1
+    OpenFileId Add(OpenFile *file);	// Take over the caller's reference
+    					// to "file", return its new id
+    OpenFile *Get(OpenFileId id);	// NULL if "id" is not open
+    int Close(OpenFileId id);		// 1 on success, -1 if not open
+    OpenFileId Dup(OpenFileId id);	// Another id for the same open file
+    void Inherit(FileTable *parent);	// Share all of parent's open files
+    void CloseAll();
+
+    // Operations on an open file by id; -1 if the id or size is bad
+    int Read(OpenFileId id, char *buffer, int size);
+    int Write(OpenFileId id, char *buffer, int size);
+    int ReadAt(OpenFileId id, char *buffer, int size, int position);
+    int WriteAt(OpenFileId id, char *buffer, int size, int position);
+    int Seek(OpenFileId id, int position);
+    int CopyRange(OpenFileId inId, OpenFileId outId, int size);
+    int Sync(OpenFileId id);
+
+  private:
+    vector<OpenFile *> files;		// indexed by OpenFileId, NULL if free
+};
+
+#endif // FILETABLE_H
@@ -0,0 +1,265 @@
+// ioring.cc
+//	Routines to process the file requests a user program has queued
+//	in an IoRing.
+//
+//	Requests run in the order they were submitted, except that a run
+//	of positional reads with nothing else in between is sorted by file
+//	and offset first.  Reads can't affect each other, so this is safe,
+//	and it lets the disk sweep forward through each file instead of
+//	seeking back and forth.  Completions are posted in the order the
+//	requests actually ran; the program matches them up by userData.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "ioring.h"
+#include "syscall.h"
+#include "filetable.h"
+
+// Words in the IoRing header, and in each queue entry
+static const int RingHeaderWords = 7;
+static const int SqeWords = 6;
+static const int CqeWords = 2;
+
+//----------------------------------------------------------------------
+// IoRingBatch::IoRingBatch
+// 	Get ready to process the ring at "ringAddr" in "space".
+//----------------------------------------------------------------------
+
+IoRingBatch::IoRingBatch(AddrSpace *space, int ringAddr)
+{
+    this->space = space;
+    this->ringAddr = ringAddr;
+    sqHead = sqTail = cqHead = cqTail = size = 0;
+    sqAddr = cqAddr = 0;
+}
+
+//----------------------------------------------------------------------
+// IoRingBatch::ReadHeader
+// 	Copy in the ring header and check that its indices make sense.
+//	Return FALSE if the ring is unreadable or corrupt.
+//----------------------------------------------------------------------
+
+bool
+IoRingBatch::ReadHeader()
+{
+    int header[RingHeaderWords];
+
+    if (!space->CopyIn(ringAddr, (char *)header, sizeof(header))) {
+	return FALSE;
+    }
+    sqHead = WordToHost(header[0]);
+    sqTail = WordToHost(header[1]);
+    cqHead = WordToHost(header[2]);
+    cqTail = WordToHost(header[3]);
+    size = WordToHost(header[4]);
+    sqAddr = WordToHost(header[5]);
+    cqAddr = WordToHost(header[6]);
+
+    return size > 0 && sqTail - sqHead >= 0 && sqTail - sqHead <= size
+	&& cqTail - cqHead >= 0 && cqTail - cqHead <= size;
+}
+
+//----------------------------------------------------------------------
+// IoRingBatch::ReadRequest
+// 	Copy in submission entry "index".  Return FALSE if it is unmapped.
+//----------------------------------------------------------------------
+
+bool
+IoRingBatch::ReadRequest(int index, IoRequest *req)
+{
+    int sqe[SqeWords];
+    int slot = index % size;
+
+    if (!space->CopyIn(sqAddr + slot * sizeof(sqe), (char *)sqe, sizeof(sqe))) {
+	return FALSE;
+    }
+    req->op = WordToHost(sqe[0]);
+    req->fd = WordToHost(sqe[1]);
+    req->buf = WordToHost(sqe[2]);
+    req->len = WordToHost(sqe[3]);
+    req->position = WordToHost(sqe[4]);
+    req->userData = WordToHost(sqe[5]);
+    req->seq = index;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// IoRingBatch::PostCompletion
+// 	Fill in the completion entry at cqTail and advance it.  Submit has
+//	already made sure there is room.
+//----------------------------------------------------------------------
+
+bool
+IoRingBatch::PostCompletion(int userData, int result)
+{
+    int cqe[CqeWords];
+    int slot = cqTail % size;
+
+    cqe[0] = WordToMachine(userData);
+    cqe[1] = WordToMachine(result);
+    if (!space->CopyOut(cqAddr + slot * sizeof(cqe), (char *)cqe, sizeof(cqe))) {
+	return FALSE;
+    }
+    cqTail++;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// IoRingBatch::SortReads
+// 	Sort each run of positional reads in "reqs" by file and offset,
+//	keeping everything else where it is.  An insertion sort is plenty
+//	for a batch this small.
+//----------------------------------------------------------------------
+
+static bool
+IsPositionalRead(IoRequest *req)
+{
+    return req->op == IO_OP_READ && req->position >= 0;
+}
+
+static bool
+ReadsBefore(IoRequest *a, IoRequest *b)
+{
+    if (a->fd != b->fd) {
+	return a->fd < b->fd;
+    }
+    if (a->position != b->position) {
+	return a->position < b->position;
+    }
+    return a->seq < b->seq;
+}
+
+void
+IoRingBatch::SortReads(IoRequest *reqs, int count)
+{
+    int start = 0;
+
+    while (start < count) {
+	int end = start;
+	while (end < count && IsPositionalRead(&reqs[end])) {
+	    end++;
+	}
+	for (int i = start + 1; i < end; i++) {
+	    IoRequest req = reqs[i];
+	    int j = i - 1;
+	    while (j >= start && ReadsBefore(&req, &reqs[j])) {
+		reqs[j + 1] = reqs[j];
+		j--;
+	    }
+	    reqs[j + 1] = req;
+	}
+	start = end + 1;
+    }
+}
+
+//----------------------------------------------------------------------
+// IoRingBatch::Run
+// 	Carry out one request, moving data between the user buffer and
+//	the file through a kernel buffer.  Return what the matching system
+//	call would have returned.
+//----------------------------------------------------------------------
+
+int
+IoRingBatch::Run(IoRequest *req)
+{
+    FileTable *files = space->getFileTable();
+    int result = -1;
+
+    switch (req->op) {
+      case IO_OP_READ:
+	if (req->len >= 0 && req->len <= space->Size()) {
+	    char *buffer = new char[req->len];
+	    if (req->position >= 0) {
+		result = files->ReadAt(req->fd, buffer, req->len, req->position);
+	    } else {
+		result = files->Read(req->fd, buffer, req->len);
+	    }
+	    if (result > 0 && !space->CopyOut(req->buf, buffer, result)) {
+		result = -1;
+	    }
+	    delete [] buffer;
+	}
+	break;
+      case IO_OP_WRITE:
+	if (req->len >= 0 && req->len <= space->Size()) {
+	    char *buffer = new char[req->len];
+	    if (space->CopyIn(req->buf, buffer, req->len)) {
+		if (req->position >= 0) {
+		    result = files->WriteAt(req->fd, buffer, req->len, req->position);
+		} else {
+		    result = files->Write(req->fd, buffer, req->len);
+		}
+	    }
+	    delete [] buffer;
+	}
+	break;
+      case IO_OP_OPEN:
+	{
+	    char name[PATH_NAME_MAX_LEN + 1];
+	    if (space->CopyInString(req->buf, name, PATH_NAME_MAX_LEN + 1)) {
+		result = files->Open(name);
+	    }
+	}
+	break;
+      case IO_OP_CLOSE:
+	result = files->Close(req->fd);
+	break;
+    }
+    DEBUG(dbgFile, "IoRing op " << req->op << " on " << req->fd << " returned " << result);
+    return result;
+}
+
+//----------------------------------------------------------------------
+// IoRingBatch::Submit
+// 	Take the queued submissions, as many as there is room for in the
+//	completion queue (and at most IoRingBatchLimit), run them, and
+//	post their completions.  Then store the new sqHead and cqTail back
+//	into the ring header.
+//
+//	Return the number of requests run, or -1 if the ring is bad.  If
+//	a completion cannot be posted, the requests have still been run,
+//	so sqHead moves past them all and only their completions are lost.
+//----------------------------------------------------------------------
+
+int
+IoRingBatch::Submit()
+{
+    IoRequest reqs[IoRingBatchLimit];
+    int results[IoRingBatchLimit];
+    int count, word;
+    bool posted = TRUE;
+
+    if (!ReadHeader()) {
+	return -1;
+    }
+    count = min(sqTail - sqHead, size - (cqTail - cqHead));
+    count = min(count, IoRingBatchLimit);
+    for (int i = 0; i < count; i++) {
+	if (!ReadRequest(sqHead + i, &reqs[i])) {
+	    return -1;
+	}
+    }
+
+    SortReads(reqs, count);
+    for (int i = 0; i < count; i++) {
+	results[i] = Run(&reqs[i]);
+    }
+    for (int i = 0; i < count && posted; i++) {
+	posted = PostCompletion(reqs[i].userData, results[i]);
+    }
+    sqHead += count;
+
+    word = WordToMachine(sqHead);
+    if (!space->CopyOut(ringAddr, (char *)&word, sizeof(word))) {
+	return -1;
+    }
+    word = WordToMachine(cqTail);
+    if (!space->CopyOut(ringAddr + 3 * sizeof(word), (char *)&word, sizeof(word))) {
+	return -1;
+    }
+    return posted ? count : -1;
+}
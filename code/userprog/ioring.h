@@ -0,0 +1,65 @@
+// ioring.h
+//	Data structures for processing a batch of file requests that a
+//	user program has queued in an IoRing in its own memory (see
+//	IoSubmit in syscall.h).
+//
+//	The program fills in submission entries and advances sqTail; one
+//	IoSubmit system call then has the kernel take every queued entry,
+//	run it, and post a completion entry for it, advancing sqHead and
+//	cqTail.  The ring indices run freely; entry i lives in slot
+//	i % size.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef IORING_H
+#define IORING_H
+
+#include "copyright.h"
+#include "addrspace.h"
+
+// Most requests handled by one IoSubmit; the rest wait for the next
+const int IoRingBatchLimit = 64;
+
+// The kernel's copy of an IoSqe (see syscall.h); every field is a word
+class IoRequest {
+  public:
+    int op;				// IO_OP_*
+    int fd;				// OpenFileId the request is for
+    int buf;				// user buffer, or file name for open
+    int len;				// bytes to transfer
+    int position;			// file offset, -1 for the seek position
+    int userData;			// handed back in the completion
+    int seq;				// order the request was submitted in
+};
+
+// The following class processes one IoSubmit call on a ring
+
+class IoRingBatch {
+  public:
+    IoRingBatch(AddrSpace *space, int ringAddr);
+    					// The ring header is at ringAddr
+
+    int Submit();			// Run the queued requests, return
+    					// how many, -1 if the ring is bad
+
+  private:
+    AddrSpace *space;			// where the ring lives
+    int ringAddr;			// user address of the IoRing
+    int sqHead, sqTail, cqHead, cqTail;	// ring indices
+    int size;				// slots in each queue
+    int sqAddr, cqAddr;			// user addresses of the queues
+
+    bool ReadHeader();			// Copy in and check the ring header
+    bool ReadRequest(int index, IoRequest *req);
+    					// Copy in submission entry "index"
+    bool PostCompletion(int userData, int result);
+    					// Fill the next completion entry
+    void SortReads(IoRequest *reqs, int count);
+    					// Order independent reads by file
+					// position
+    int Run(IoRequest *req);		// Carry out one request
+};
+
+#endif // IORING_H
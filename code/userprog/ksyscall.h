@@ -14,9 +14,16 @@
 #include "kernel.h"
 
 #include "synchconsole.h"
+#include "synchdisk.h"
+#include "ioring.h"
 
 void SysHalt()
 {
+	kernel->synchConsoleOut->Flush();
+	if (kernel->remoteDiskHost >= 0) {
+		// the network can't be waited for once we are halting
+		kernel->synchDisk->FlushAll();
+	}
 	kernel->interrupt->Halt();
 }
 
@@ -25,6 +32,11 @@ int SysAdd(int op1, int op2)
 	return op1 + op2;
 }
 
+int SysTicks()
+{
+	return kernel->stats->totalTicks;
+}
+
 int SysCreate(char *filename, int initialSize)
 {
 	// return value
@@ -41,7 +53,7 @@ int SysCreate(char *filename, int initialSize)
  */
 OpenFileId SysOpen(char *name)
 {
-	return kernel->fileSystem->OpenAFile(name);
+	return kernel->currentThread->space->getFileTable()->Open(name);
 }
 
 /**
@@ -54,7 +66,7 @@ OpenFileId SysOpen(char *name)
  */
 int SysWrite(char *buffer, int size, OpenFileId id)
 {
-	return kernel->fileSystem->WriteFile_(buffer, size, id);
+	return kernel->currentThread->space->getFileTable()->Write(id, buffer, size);
 }
 
 /**
@@ -67,7 +79,213 @@ int SysWrite(char *buffer, int size, OpenFileId id)
  */
 int SysRead(char *buffer, int size, OpenFileId id)
 {
-	return kernel->fileSystem->ReadFile(buffer, size, id);
+	return kernel->currentThread->space->getFileTable()->Read(id, buffer, size);
+}
+
+/**
+ * @brief Set the position the next Read or Write of the file starts at
+ *
+ * @param position byte offset from the start of the file
+ * @param id
+ * @return int The new position, -1 if fail
+ */
+int SysSeek(int position, OpenFileId id)
+{
+	return kernel->currentThread->space->getFileTable()->Seek(id, position);
+}
+
+/**
+ * @brief Write "size" characters from the buffer into the file at "position",
+ * without moving the seek position
+ *
+ * @param buffer
+ * @param size
+ * @param position
+ * @param id
+ * @return int The number of characters actually written to the file. Return -1, if fail to write the file
+ */
+int SysPWrite(char *buffer, int size, int position, OpenFileId id)
+{
+	return kernel->currentThread->space->getFileTable()->WriteAt(id, buffer, size, position);
+}
+
+/**
+ * @brief Read "size" characters from the file at "position" to the buffer,
+ * without moving the seek position
+ *
+ * @param buffer
+ * @param size
+ * @param position
+ * @param id
+ * @return int The number of characters actually read from the file. Return -1, if fail to read the file
+ */
+int SysPRead(char *buffer, int size, int position, OpenFileId id)
+{
+	return kernel->currentThread->space->getFileTable()->ReadAt(id, buffer, size, position);
+}
+
+/**
+ * @brief Copy in the user IoVec array at iovAddr
+ *
+ * @param iovAddr user address of the array
+ * @param count number of entries, at most IOV_LIMIT
+ * @param base filled with the user address of each piece
+ * @param len filled with the length of each piece
+ * @return int The total length of the pieces, -1 if the array is bad or
+ * the pieces add up to more than the address space holds
+ */
+static int CopyInIoVec(int iovAddr, int count, int *base, int *len)
+{
+	AddrSpace *space = kernel->currentThread->space;
+	int iov[2 * IOV_LIMIT];
+	int total = 0;
+
+	if (count < 0 || count > IOV_LIMIT ||
+		!space->CopyIn(iovAddr, (char *)iov, count * 2 * sizeof(int)))
+	{
+		return -1;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		base[i] = WordToHost(iov[2 * i]);
+		len[i] = WordToHost(iov[2 * i + 1]);
+		if (len[i] < 0 || len[i] > space->Size() - total)
+		{
+			return -1;
+		}
+		total += len[i];
+	}
+	return total;
+}
+
+/**
+ * @brief Gather the pieces of a user IoVec array and write them to the
+ * file with a single Write
+ *
+ * @param iovAddr user address of the IoVec array
+ * @param count number of pieces
+ * @param id
+ * @return int The number of characters actually written to the file. Return -1, if fail to write the file
+ */
+int SysWriteV(int iovAddr, int count, OpenFileId id)
+{
+	AddrSpace *space = kernel->currentThread->space;
+	int base[IOV_LIMIT], len[IOV_LIMIT];
+	int total = CopyInIoVec(iovAddr, count, base, len);
+	int offset = 0, result = -1;
+	char *buffer;
+
+	if (total < 0)
+	{
+		return -1;
+	}
+	buffer = new char[total];
+	for (int i = 0; i < count; i++)
+	{
+		if (!space->CopyIn(base[i], buffer + offset, len[i]))
+		{
+			break;
+		}
+		offset += len[i];
+	}
+	if (offset == total)
+	{
+		result = SysWrite(buffer, total, id);
+	}
+	delete[] buffer;
+	return result;
+}
+
+/**
+ * @brief Read from the file with a single Read and scatter the data into
+ * the pieces of a user IoVec array
+ *
+ * @param iovAddr user address of the IoVec array
+ * @param count number of pieces
+ * @param id
+ * @return int The number of characters actually read from the file. Return -1, if fail to read the file
+ */
+int SysReadV(int iovAddr, int count, OpenFileId id)
+{
+	AddrSpace *space = kernel->currentThread->space;
+	int base[IOV_LIMIT], len[IOV_LIMIT];
+	int total = CopyInIoVec(iovAddr, count, base, len);
+	int offset = 0, result;
+	char *buffer;
+
+	if (total < 0)
+	{
+		return -1;
+	}
+	buffer = new char[total];
+	result = SysRead(buffer, total, id);
+	for (int i = 0; i < count && offset < result; i++)
+	{
+		int n = min(len[i], result - offset);
+		if (!space->CopyOut(base[i], buffer + offset, n))
+		{
+			result = -1;
+			break;
+		}
+		offset += n;
+	}
+	delete[] buffer;
+	return result;
+}
+
+/**
+ * @brief Copy "size" characters from one open file to another in the kernel
+ *
+ * @param inId file copied from, starting at its seek position
+ * @param outId file copied to, starting at its seek position
+ * @param size
+ * @return int The number of characters actually copied. Return -1, if fail to copy
+ */
+int SysCopyFileRange(OpenFileId inId, OpenFileId outId, int size)
+{
+	return kernel->currentThread->space->getFileTable()->CopyRange(inId, outId, size);
+}
+
+/**
+ * @brief Run the file requests queued in a user IoRing
+ *
+ * @param ringAddr user address of the IoRing
+ * @return int The number of requests run, -1 if the ring is bad
+ */
+int SysIoSubmit(int ringAddr)
+{
+	IoRingBatch ring(kernel->currentThread->space, ringAddr);
+	return ring.Submit();
+}
+
+/**
+ * @brief Write the buffered data and header sectors of the file to disk
+ *
+ * @param id
+ * @return int 1 if success, else -1
+ */
+int SysFsync(OpenFileId id)
+{
+	return kernel->currentThread->space->getFileTable()->Sync(id);
+}
+
+/**
+ * @brief Write every buffered sector to disk
+ */
+void SysSync()
+{
+	kernel->synchDisk->FlushAll();
+}
+
+/**
+ * @brief Give an open file a second id, sharing its seek position
+ *
+ * @param id
+ * @return OpenFileId The new id, -1 if id is not open
+ */
+OpenFileId SysDup(OpenFileId id)
+{
+	return kernel->currentThread->space->getFileTable()->Dup(id);
 }
 
 /**
@@ -78,7 +296,141 @@ int SysRead(char *buffer, int size, OpenFileId id)
  */
 int SysClose(OpenFileId id)
 {
-	return kernel->fileSystem->CloseFile(id);
+	return kernel->currentThread->space->getFileTable()->Close(id);
+}
+
+// Most arguments ExecV will pass to a program
+#define EXEC_ARGS_LIMIT 16
+
+// Most bytes of the new program's stack the arguments may take up,
+// counting the strings and the argv array (see AddrSpace::PushArguments)
+#define EXEC_ARGS_SPACE (UserStackSize / 2)
+
+/**
+ * @brief Start running a program, without waiting for it to load
+ *
+ * @param name file containing the program
+ * @return SpaceId of the new program
+ */
+SpaceId SysExec(char *name)
+{
+	return kernel->Exec(name);
+}
+
+/**
+ * @brief Start running a program with arguments
+ *
+ * @param argc number of arguments, including the program file
+ * @param argvAddr user address of the argv array of string pointers
+ * @return SpaceId of the new program, -1 if the arguments are bad or
+ * take up more than EXEC_ARGS_SPACE bytes
+ */
+SpaceId SysExecV(int argc, int argvAddr)
+{
+	AddrSpace *space = kernel->currentThread->space;
+	char *argv[EXEC_ARGS_LIMIT];
+	int i, result = -1;
+	int argBytes = (argc + 1) * 4 + 3; // argv array, alignment
+
+	if (argc <= 0 || argc > EXEC_ARGS_LIMIT)
+	{
+		return -1;
+	}
+	for (i = 0; i < argc; i++)
+	{
+		int argAddr;
+		argv[i] = new char[PATH_NAME_MAX_LEN + 1];
+		if (!space->CopyIn(argvAddr + i * 4, (char *)&argAddr, 4) ||
+			!space->CopyInString(WordToHost(argAddr), argv[i], PATH_NAME_MAX_LEN + 1))
+		{
+			break;
+		}
+		argBytes += strlen(argv[i]) + 1;
+	}
+	if (i == argc && argBytes <= EXEC_ARGS_SPACE)
+	{
+		result = kernel->ExecV(argc, argv); // copies the strings
+	}
+	for (int j = 0; j <= i && j < argc; j++)
+	{
+		delete[] argv[j];
+	}
+	return result;
+}
+
+/**
+ * @brief Wait for a child program to exit
+ *
+ * @param id
+ * @return int The exit status of the program, -1 if it is not our child
+ */
+int SysJoin(SpaceId id)
+{
+	return kernel->Join(id);
+}
+
+/**
+ * @brief The current program is done; finish the calling thread
+ *
+ * @param status exit status handed to Join
+ */
+void SysExit(int status)
+{
+	kernel->synchConsoleOut->Flush();
+	cout << "return value:" << status << endl;
+	kernel->currentThread->space->Exit(status);
+	kernel->currentThread->space->ThreadExited(kernel->currentThread->getID(), status);
+	kernel->currentThread->Finish();
+}
+
+/**
+ * @brief Fork a user thread in the address space of the current thread
+ *
+ * @param func user procedure for the thread to run
+ * @param retAddr user address the procedure returns to
+ * @return ThreadId of the new thread, -1 if it could not be created
+ */
+ThreadId SysThreadFork(int func, int retAddr)
+{
+	return kernel->ThreadFork(func, retAddr);
+}
+
+/**
+ * @brief Give up the CPU to another ready thread
+ */
+void SysThreadYield()
+{
+	kernel->currentThread->Yield();
+}
+
+/**
+ * @brief Finish the current thread, handing exitCode to its joiners
+ *
+ * @param exitCode
+ */
+void SysThreadExit(int exitCode)
+{
+	Thread *thread = kernel->currentThread;
+
+	thread->space->ThreadExited(thread->getID(), exitCode);
+	thread->Finish();
+}
+
+/**
+ * @brief Wait for a thread of the current address space to exit
+ *
+ * @param id
+ * @return int The exit code of the thread, -1 if there is no such thread
+ */
+int SysThreadJoin(ThreadId id)
+{
+	Thread *thread = kernel->currentThread;
+
+	if (id == thread->getID())
+	{
+		return -1; // would wait forever
+	}
+	return thread->space->ThreadJoin(id);
 }
 
 #ifdef FILESYS_STUB
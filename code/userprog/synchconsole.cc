@@ -22,6 +22,7 @@ SynchConsoleInput::SynchConsoleInput(char *inputFile)
     consoleInput = new ConsoleInput(inputFile, this);
     lock = new Lock("console in");
     waitFor = new Semaphore("console in", 0);
+    atEnd = FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -53,6 +54,36 @@ SynchConsoleInput::GetChar()
     return ch;
 }
 
+//----------------------------------------------------------------------
+// SynchConsoleInput::GetString
+//      Read characters typed at the keyboard into "into", until a
+//	newline, "size" characters, or the end of the input.  Return the
+//	number read; 0 once the input has run out.  After the end of the
+//	input no more interrupts come, so don't wait for one.
+//----------------------------------------------------------------------
+
+int
+SynchConsoleInput::GetString(char *into, int size)
+{
+    int count = 0;
+
+    lock->Acquire();
+    while (count < size && !atEnd) {
+	waitFor->P();	// wait for EOF or a char to be available.
+	char ch = consoleInput->GetChar();
+	if (ch == EOF) {
+	    atEnd = TRUE;
+	    break;
+	}
+	into[count++] = ch;
+	if (ch == '\n') {
+	    break;
+	}
+    }
+    lock->Release();
+    return count;
+}
+
 //----------------------------------------------------------------------
 // SynchConsoleInput::CallBack
 //      Interrupt handler called when keystroke is hit; wake up
@@ -78,6 +109,7 @@ SynchConsoleOutput::SynchConsoleOutput(char *outputFile)
     consoleOutput = new ConsoleOutput(outputFile, this);
     lock = new Lock("console out");
     waitFor = new Semaphore("console out", 0);
+    lineLength = 0;
 }
 
 //----------------------------------------------------------------------
@@ -87,6 +119,9 @@ SynchConsoleOutput::SynchConsoleOutput(char *outputFile)
 
 SynchConsoleOutput::~SynchConsoleOutput()
 { 
+    if (lineLength > 0) {	// Nachos is halting; don't wait for
+	consoleOutput->WriteNow(line, lineLength);	// an interrupt
+    }
     delete consoleOutput; 
     delete lock; 
     delete waitFor;
@@ -101,11 +136,62 @@ void
 SynchConsoleOutput::PutChar(char ch)
 {
     lock->Acquire();
+    FlushLine();		// keep the output in order
     consoleOutput->PutChar(ch);
     waitFor->P();
     lock->Release();
 }
 
+//----------------------------------------------------------------------
+// SynchConsoleOutput::PutString
+//      Write characters to the console display, a line at a time.
+//	Each complete line (or full buffer) goes out as one transfer;
+//	a trailing partial line waits for more output or for Flush.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleOutput::PutString(char *str, int len)
+{
+    lock->Acquire();
+    for (int i = 0; i < len; i++) {
+	line[lineLength++] = str[i];
+	if (str[i] == '\n' || lineLength == ConsoleLineSize) {
+	    FlushLine();
+	}
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleOutput::Flush
+//      Write out any partial line, as before reading the console or
+//	when a program exits.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleOutput::Flush()
+{
+    lock->Acquire();
+    FlushLine();
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleOutput::FlushLine
+//      Send the buffered characters to the display and wait for the
+//	transfer to finish.  The caller holds the lock.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleOutput::FlushLine()
+{
+    if (lineLength > 0) {
+	consoleOutput->PutString(line, lineLength);
+	waitFor->P();
+	lineLength = 0;
+    }
+}
+
 //----------------------------------------------------------------------
 // SynchConsoleOutput::CallBack
 //      Interrupt handler called when it's safe to send the next 
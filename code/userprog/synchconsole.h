@@ -17,6 +17,9 @@
 #include "console.h"
 #include "synch.h"
 
+// Longest run of output characters buffered before they are written
+const int ConsoleLineSize = 128;
+
 // The following two classes define synchronized input and output to
 // a console device
 
@@ -28,9 +31,13 @@ class SynchConsoleInput : public CallBackObj {
 	void Disable() { consoleInput->Disable(); }// 2015.11.25
 
     char GetChar();		// Read a character, waiting if necessary
+    int GetString(char *into, int size);
+    				// Read up to "size" characters, stopping
+				// after a newline; 0 at end of input
     
   private:
     ConsoleInput *consoleInput;	// the hardware keyboard
+    bool atEnd;			// has the input run out?
     Lock *lock;			// only one reader at a time
     Semaphore *waitFor;		// wait for callBack
 
@@ -43,12 +50,19 @@ class SynchConsoleOutput : public CallBackObj {
     ~SynchConsoleOutput();
 
     void PutChar(char ch);	// Write a character, waiting if necessary
+    void PutString(char *str, int len);
+    				// Buffer characters, writing out each
+				// complete line as one transfer
+    void Flush();		// Write out any partial line
    
   private:
     ConsoleOutput *consoleOutput;// the hardware display
     Lock *lock;			// only one writer at a time
     Semaphore *waitFor;		// wait for callBack
+    char line[ConsoleLineSize];	// characters not yet written
+    int lineLength;
 
+    void FlushLine();		// Write out line; caller holds lock
     void CallBack();		// called when more data can be written
 };
 
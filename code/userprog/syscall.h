@@ -34,6 +34,16 @@
 #define SC_ExecV	13
 #define SC_ThreadExit   14
 #define SC_ThreadJoin   15
+#define SC_PRead	16
+#define SC_PWrite	17
+#define SC_ReadV	18
+#define SC_WriteV	19
+#define SC_CopyFileRange	20
+#define SC_IoSubmit	21
+#define SC_Dup		22
+#define SC_Fsync	23
+#define SC_Sync		24
+#define SC_Ticks	25
 #define SC_Add		42
 #define SC_MSG		100
 
@@ -62,6 +72,11 @@ int Add(int op1, int op2);
  */
 void MSG(char *msg);
 
+/* Return the simulated time, in ticks, since Nachos started; for
+ * programs that time themselves
+ */
+int Ticks();
+
 /* Address space control operations: Exit, Exec, Execv, and Join */
 
 /* This user program is done (status = 0 means exited normally). */
@@ -105,7 +120,9 @@ typedef int OpenFileId;
 /* when an address space starts up, it has two open files, representing 
  * keyboard input and display output (in UNIX terms, stdin and stdout).
  * Read and Write can be used directly on these, without first opening
- * the console device.
+ * the console device.  Read returns at most one line.  Output is line
+ * buffered: a partial line appears once the program reads the console,
+ * exits, or halts.
  */
 
 #define SysConsoleInput	0  
@@ -141,10 +158,94 @@ int Write(char *buffer, int size, OpenFileId id);
 int Read(char *buffer, int size, OpenFileId id);
 
 /* Set the seek position of the open file "id"
- * to the byte "position".
+ * to the byte "position".  Return the new position, or -1 on failure.
  */
 int Seek(int position, OpenFileId id);
 
+/* Read or write "size" bytes at byte "position" of the open file,
+ * without using or moving its seek position.  Return the number of
+ * bytes actually transferred, or -1 on failure.
+ */
+int PRead(char *buffer, int size, int position, OpenFileId id);
+int PWrite(char *buffer, int size, int position, OpenFileId id);
+
+/* One piece of a scattered buffer, for ReadV and WriteV. */
+typedef struct {
+    char *base;
+    int len;
+} IoVec;
+
+/* Most pieces ReadV and WriteV accept in one call */
+#define IOV_LIMIT	16
+
+/* Write the "count" pieces of "iov", in order, to the open file as
+ * one Write; or Read from the open file into them in order.
+ * Return the total number of bytes transferred, or -1 on failure.
+ */
+int WriteV(IoVec *iov, int count, OpenFileId id);
+int ReadV(IoVec *iov, int count, OpenFileId id);
+
+/* Copy "size" bytes from the seek position of open file "in" to the
+ * seek position of open file "out", inside the kernel, advancing both.
+ * Return the number of bytes copied, or -1 on failure.
+ */
+int CopyFileRange(OpenFileId in, OpenFileId out, int size);
+
+/* Batched file requests.  A program queues requests in the submission
+ * queue of an IoRing and advances sqTail; IoSubmit then runs them all
+ * with one system call, posting one completion per request and
+ * advancing sqHead and cqTail.  The program takes completions from
+ * cqHead.  Indices run freely: entry i lives in slot i % size of the
+ * queue.  Independent positional reads may run out of order, so match
+ * completions to requests with userData.
+ */
+#define IO_OP_READ	0	/* Read, or PRead if position >= 0 */
+#define IO_OP_WRITE	1	/* Write, or PWrite if position >= 0 */
+#define IO_OP_OPEN	2	/* Open the file named by buf */
+#define IO_OP_CLOSE	3	/* Close fd */
+
+typedef struct {
+    int op;		/* IO_OP_* */
+    OpenFileId fd;
+    char *buf;
+    int len;
+    int position;	/* -1 to use the seek position */
+    int userData;	/* copied into the completion */
+} IoSqe;
+
+typedef struct {
+    int userData;
+    int result;		/* what the matching system call returns */
+} IoCqe;
+
+typedef struct {
+    int sqHead;		/* advanced by the kernel */
+    int sqTail;		/* advanced by the program */
+    int cqHead;		/* advanced by the program */
+    int cqTail;		/* advanced by the kernel */
+    int size;		/* entries in each queue */
+    IoSqe *sq;
+    IoCqe *cq;
+} IoRing;
+
+/* Run the requests queued in "ring", as many as fit in its completion
+ * queue.  Return how many were run, or -1 if the ring is bad.
+ */
+int IoSubmit(IoRing *ring);
+
+/* Writes are buffered in the kernel.  Fsync returns once everything
+ * written to the open file "id" is on disk (1, or -1 on failure); Sync
+ * does the same for every file.
+ */
+int Fsync(OpenFileId id);
+void Sync();
+
+/* Return a second OpenFileId for the open file "id".  Both ids share
+ * one seek position; the file stays open until both are closed.
+ * Return -1 on failure.
+ */
+OpenFileId Dup(OpenFileId id);
+
 /* Close the file, we're done reading and writing to it.
  * Return 1 on success, negative error code on failure
  */
@@ -158,7 +259,8 @@ int Close(OpenFileId id);
  */
 
 /* Fork a thread to run a procedure ("func") in the *same* address space 
- * as the current thread.
+ * as the current thread, on a stack of its own.  If "func" returns, the
+ * thread exits with status 0.
  * Return a positive ThreadId on success, negative error code on failure
  */
 ThreadId ThreadFork(void (*func)());